@@ -2,6 +2,7 @@
 
 import { useState, useEffect, useCallback, useRef, useMemo } from 'react';
 import { useKeyboard } from '../hooks/useKeyboard';
+import { SWITCH_TYPES, getSwitchTravelMm, type KeyUsageData } from '../utils/emberProtocol';
 import { getKeyByCode, KEY_MAPPINGS, type KeyMapping } from '../utils/keyMapping';
 import PushDistanceVisualizer from '../components/PushDistanceVisualizer';
 
@@ -57,17 +58,25 @@ interface KeySettings {
   label: string;
   keyCode: number | null;
   actuationPoint: number; // mm
+  releasePoint: number; // mm
   rapidTrigger: boolean;
   rapidTriggerUpSensitivity: number; // mm
   rapidTriggerDownSensitivity: number; // mm
+  switchType: number;
+  rapidTriggerUpperLimit: number; // mm, 0 = no limit
+  rapidTriggerLowerLimit: number; // mm, 0 = no limit
 }
 
 const DEFAULT_KEY_SETTINGS: Omit<KeySettings, 'keyId' | 'label'> = {
   keyCode: null,
   actuationPoint: 2.0,
+  releasePoint: 0.8,
   rapidTrigger: false,
   rapidTriggerUpSensitivity: 0.1,
   rapidTriggerDownSensitivity: 0.1,
+  switchType: 0,
+  rapidTriggerUpperLimit: 0,
+  rapidTriggerLowerLimit: 0,
 };
 
 const DEFAULT_RAPID_TRIGGER_KEY_IDS = new Set([10, 16, 17, 18]);
@@ -85,6 +94,9 @@ export default function Home() {
   const [isSavingSettings, setIsSavingSettings] = useState(false);
   const [isResettingSettings, setIsResettingSettings] = useState(false);
   const [isEnteringDfu, setIsEnteringDfu] = useState(false);
+  const [usageStats, setUsageStats] = useState<KeyUsageData[] | null>(null);
+  const [showHeatmap, setShowHeatmap] = useState(false);
+  const [isLoadingUsage, setIsLoadingUsage] = useState(false);
   
   const { 
     isSupported, 
@@ -107,7 +119,9 @@ export default function Home() {
     stopCalibration,
     readKeySwitchConfig,
     writeKeySwitchConfig,
-    enterDfuMode
+    enterDfuMode,
+    readUsageStats,
+    clearUsageStats
   } = useKeyboard();
 
   const loadKeyMappings = useCallback(async () => {
@@ -256,9 +270,13 @@ export default function Home() {
         label: key.label || `Key ${key.id}`,
         keyCode: existingKeyCode,
         actuationPoint: DEFAULT_KEY_SETTINGS.actuationPoint,
+        releasePoint: DEFAULT_KEY_SETTINGS.releasePoint,
         rapidTrigger: DEFAULT_RAPID_TRIGGER_KEY_IDS.has(key.id),
         rapidTriggerUpSensitivity: DEFAULT_KEY_SETTINGS.rapidTriggerUpSensitivity,
         rapidTriggerDownSensitivity: DEFAULT_KEY_SETTINGS.rapidTriggerDownSensitivity,
+        switchType: DEFAULT_KEY_SETTINGS.switchType,
+        rapidTriggerUpperLimit: DEFAULT_KEY_SETTINGS.rapidTriggerUpperLimit,
+        rapidTriggerLowerLimit: DEFAULT_KEY_SETTINGS.rapidTriggerLowerLimit,
       };
     });
     return defaults;
@@ -287,8 +305,12 @@ export default function Home() {
             keyCode: config.keyCode ?? baseDefaults.keyCode ?? null,
             rapidTrigger: config.keyType === 1,
             actuationPoint: roundToTenth(config.actuationPointMm),
+            releasePoint: roundToTenth(config.releasePointMm),
             rapidTriggerUpSensitivity: roundToTenth(config.rapidTriggerUpSensitivityMm),
             rapidTriggerDownSensitivity: roundToTenth(config.rapidTriggerDownSensitivityMm),
+            switchType: config.switchType,
+            rapidTriggerUpperLimit: roundToTenth(config.rapidTriggerUpperLimitMm),
+            rapidTriggerLowerLimit: roundToTenth(config.rapidTriggerLowerLimitMm),
           };
         });
         return next;
@@ -298,6 +320,33 @@ export default function Home() {
     }
   }, [buildDefaultKeySettings, isConnected, readAllKeySwitchConfigs, roundToTenth]);
 
+  const handleSwitchTypeChange = useCallback(async (keyId: number, switchType: number) => {
+    updateKeySettings(keyId, { switchType });
+    if (!isConnected) return;
+
+    try {
+      const success = await writeKeySwitchConfig(keyId, { switchType });
+      if (!success) {
+        console.error(`Failed to write switch type for key ${keyId}`);
+        return;
+      }
+      // The device applies the profile on its next scan
+      await new Promise(resolve => setTimeout(resolve, 20));
+      const config = await readKeySwitchConfig(keyId);
+      if (config) {
+        updateKeySettings(keyId, {
+          switchType: config.switchType,
+          actuationPoint: roundToTenth(config.actuationPointMm),
+          releasePoint: roundToTenth(config.releasePointMm),
+          rapidTriggerUpSensitivity: roundToTenth(config.rapidTriggerUpSensitivityMm),
+          rapidTriggerDownSensitivity: roundToTenth(config.rapidTriggerDownSensitivityMm),
+        });
+      }
+    } catch (error) {
+      console.error(`Failed to apply switch type for key ${keyId}:`, error);
+    }
+  }, [isConnected, readKeySwitchConfig, roundToTenth, updateKeySettings, writeKeySwitchConfig]);
+
   const handleSaveAllSettings = useCallback(async () => {
     if (!isConnected) {
       console.warn('Cannot save settings while the keyboard is disconnected.');
@@ -357,6 +406,61 @@ export default function Home() {
     }
   }, [enterDfuMode, isConnected]);
 
+  const handleToggleHeatmap = useCallback(async () => {
+    if (showHeatmap) {
+      setShowHeatmap(false);
+      return;
+    }
+    if (!isConnected) return;
+
+    setIsLoadingUsage(true);
+    try {
+      const usage = await readUsageStats();
+      if (usage) {
+        setUsageStats(usage);
+        setShowHeatmap(true);
+      } else {
+        console.error('Failed to read usage statistics.');
+      }
+    } catch (error) {
+      console.error('Error while reading usage statistics:', error);
+    } finally {
+      setIsLoadingUsage(false);
+    }
+  }, [isConnected, readUsageStats, showHeatmap]);
+
+  const handleClearUsage = useCallback(async () => {
+    if (!isConnected) return;
+    if (!window.confirm('Clear the usage statistics stored on the keyboard?')) return;
+
+    try {
+      const success = await clearUsageStats();
+      if (success) {
+        setUsageStats(prev => prev && prev.map(() => ({
+          actuations: 0,
+          dwellHistogram: new Array(8).fill(0),
+          depthHistogram: new Array(8).fill(0),
+        })));
+      } else {
+        console.error('Failed to clear usage statistics.');
+      }
+    } catch (error) {
+      console.error('Error while clearing usage statistics:', error);
+    }
+  }, [clearUsageStats, isConnected]);
+
+  const maxActuations = useMemo(
+    () => Math.max(1, ...(usageStats ?? []).map(usage => usage.actuations)),
+    [usageStats],
+  );
+
+  // Heat color from blue (unused) to red (most used)
+  const getHeatmapColor = useCallback((keyId: number): string | undefined => {
+    if (!showHeatmap || !usageStats) return undefined;
+    const ratio = (usageStats[keyId]?.actuations ?? 0) / maxActuations;
+    return `hsl(${Math.round(240 * (1 - ratio))}, 70%, ${Math.round(25 + 25 * ratio)}%)`;
+  }, [maxActuations, showHeatmap, usageStats]);
+
   // Auto-start monitoring when key is selected
   useEffect(() => {
     const stopExistingMonitoring = stopMonitoringRef.current;
@@ -413,9 +517,13 @@ export default function Home() {
 
         updateKeySettings(selectedKey, {
           actuationPoint: roundToTenth(config.actuationPointMm),
+          releasePoint: roundToTenth(config.releasePointMm),
           rapidTriggerUpSensitivity: roundToTenth(config.rapidTriggerUpSensitivityMm),
           rapidTriggerDownSensitivity: roundToTenth(config.rapidTriggerDownSensitivityMm),
           rapidTrigger: config.keyType === 1,
+          switchType: config.switchType,
+          rapidTriggerUpperLimit: roundToTenth(config.rapidTriggerUpperLimitMm),
+          rapidTriggerLowerLimit: roundToTenth(config.rapidTriggerLowerLimitMm),
         });
       } catch (err) {
         console.error(`Failed to load key config for key ${selectedKey}:`, err);
@@ -645,9 +753,15 @@ export default function Home() {
                             height: `${(key.height || 1) * 60 - 8}px`, // -8px for gap
                             transform: key.angle ? `rotate(${key.angle}deg)` : undefined,
                             transformOrigin: 'center',
+                            backgroundColor: selectedKey === key.id ? undefined : getHeatmapColor(key.id),
                           }}
                         >
-                          {getKeyDisplayLabel(key)}
+                          {showHeatmap && usageStats ? (
+                            <span className="flex flex-col items-center leading-tight">
+                              <span>{getKeyDisplayLabel(key)}</span>
+                              <span className="text-xs opacity-80">{usageStats[key.id]?.actuations ?? 0}</span>
+                            </span>
+                          ) : getKeyDisplayLabel(key)}
                         </button>
                       ))}
                     </div>
@@ -697,6 +811,37 @@ export default function Home() {
                       </div>
                     )}
 
+                    {/* Usage Statistics */}
+                    <div className="flex space-x-2">
+                      <button
+                        onClick={handleToggleHeatmap}
+                        disabled={!isConnected || isLoadingUsage}
+                        className={`flex-1 flex items-center justify-center space-x-2 px-4 py-2 rounded-md text-sm font-medium transition-colors ${
+                          !isConnected || isLoadingUsage
+                            ? 'bg-gray-400 text-white cursor-not-allowed'
+                            : showHeatmap
+                              ? 'bg-orange-600 hover:bg-orange-700 text-white'
+                              : 'bg-gray-600 hover:bg-gray-700 text-white'
+                        }`}
+                      >
+                        <span>{isLoadingUsage ? '⏳' : '🔥'}</span>
+                        <span>{showHeatmap ? 'Hide Usage Heatmap' : 'Show Usage Heatmap'}</span>
+                      </button>
+
+                      <button
+                        onClick={handleClearUsage}
+                        disabled={!isConnected}
+                        className={`flex-1 flex items-center justify-center space-x-2 px-4 py-2 rounded-md text-sm font-medium transition-colors ${
+                          !isConnected
+                            ? 'bg-gray-400 text-white cursor-not-allowed'
+                            : 'bg-gray-600 hover:bg-gray-700 text-white'
+                        }`}
+                      >
+                        <span>🧹</span>
+                        <span>Clear Usage</span>
+                      </button>
+                    </div>
+
                     {/* Global Key Actions */}
                     <div className="space-y-3">
                       <button
@@ -818,6 +963,23 @@ export default function Home() {
                     <div className="bg-white rounded-lg p-4 shadow-sm">
                       <h4 className="font-semibold text-gray-900 mb-3">Hall Effect Settings</h4>
                       <div className="space-y-4">
+                        <div>
+                          <label className="block text-sm font-medium text-gray-700 mb-1">
+                            Switch Type
+                          </label>
+                          <select
+                            value={selectedKeySettings.switchType}
+                            onChange={(e) => handleSwitchTypeChange(selectedKeySettings.keyId, Number(e.target.value))}
+                            className="w-full px-3 py-2 border border-gray-300 rounded-md focus:outline-none focus:ring-2 focus:ring-blue-500 bg-white"
+                          >
+                            {SWITCH_TYPES.map((type) => (
+                              <option key={type.value} value={type.value}>
+                                {type.name} ({type.travelMm.toFixed(1)}mm)
+                              </option>
+                            ))}
+                          </select>
+                        </div>
+
                         <div>
                           <label className="block text-sm font-medium text-gray-700 mb-1">
                             Actuation Point: {selectedKeySettings.actuationPoint}mm
@@ -825,7 +987,7 @@ export default function Home() {
                           <input
                             type="range"
                             min="0.5"
-                            max="4.0"
+                            max={getSwitchTravelMm(selectedKeySettings.switchType)}
                             step="0.1"
                             value={selectedKeySettings.actuationPoint}
                             onChange={async (e) => {
@@ -841,7 +1003,34 @@ export default function Home() {
                           />
                           <div className="flex justify-between text-xs text-gray-500 mt-1">
                             <span>0.5mm</span>
-                            <span>4.0mm</span>
+                            <span>{getSwitchTravelMm(selectedKeySettings.switchType).toFixed(1)}mm</span>
+                          </div>
+                        </div>
+
+                        <div>
+                          <label className="block text-sm font-medium text-gray-700 mb-1">
+                            Release Point: {selectedKeySettings.releasePoint}mm
+                          </label>
+                          <input
+                            type="range"
+                            min="0.0"
+                            max={selectedKeySettings.actuationPoint}
+                            step="0.1"
+                            value={Math.min(selectedKeySettings.releasePoint, selectedKeySettings.actuationPoint)}
+                            onChange={async (e) => {
+                              const rawValue = parseFloat(e.target.value);
+                              const roundedValue = roundToTenth(rawValue);
+                              updateKeySettings(selectedKeySettings.keyId, { releasePoint: roundedValue });
+                              const success = await writeKeySwitchConfig(selectedKeySettings.keyId, { releasePointMm: roundedValue });
+                              if (!success) {
+                                console.error(`Failed to write release point for key ${selectedKeySettings.keyId}`);
+                              }
+                            }}
+                            className="w-full"
+                          />
+                          <div className="flex justify-between text-xs text-gray-500 mt-1">
+                            <span>0.0mm</span>
+                            <span>{selectedKeySettings.actuationPoint}mm</span>
                           </div>
                         </div>
                         
@@ -924,6 +1113,50 @@ export default function Home() {
                                 <span>1.0mm</span>
                               </div>
                             </div>
+
+                            <div>
+                              <label className="block text-sm font-medium text-gray-700 mb-1">
+                                Active Zone: {selectedKeySettings.rapidTriggerUpperLimit.toFixed(1)}mm - {(selectedKeySettings.rapidTriggerLowerLimit || getSwitchTravelMm(selectedKeySettings.switchType)).toFixed(1)}mm
+                              </label>
+                              <input
+                                type="range"
+                                min="0.0"
+                                max={getSwitchTravelMm(selectedKeySettings.switchType)}
+                                step="0.1"
+                                value={selectedKeySettings.rapidTriggerUpperLimit}
+                                onChange={async (e) => {
+                                  const roundedValue = roundToTenth(parseFloat(e.target.value));
+                                  updateKeySettings(selectedKeySettings.keyId, { rapidTriggerUpperLimit: roundedValue });
+                                  const success = await writeKeySwitchConfig(selectedKeySettings.keyId, { rapidTriggerUpperLimitMm: roundedValue });
+                                  if (!success) {
+                                    console.error(`Failed to write rapid trigger upper limit for key ${selectedKeySettings.keyId}`);
+                                  }
+                                }}
+                                className="w-full"
+                              />
+                              <input
+                                type="range"
+                                min="0.0"
+                                max={getSwitchTravelMm(selectedKeySettings.switchType)}
+                                step="0.1"
+                                value={selectedKeySettings.rapidTriggerLowerLimit || getSwitchTravelMm(selectedKeySettings.switchType)}
+                                onChange={async (e) => {
+                                  const travel = getSwitchTravelMm(selectedKeySettings.switchType);
+                                  const roundedValue = roundToTenth(parseFloat(e.target.value));
+                                  // The full travel means no lower limit
+                                  const limit = roundedValue >= travel ? 0 : roundedValue;
+                                  updateKeySettings(selectedKeySettings.keyId, { rapidTriggerLowerLimit: limit });
+                                  const success = await writeKeySwitchConfig(selectedKeySettings.keyId, { rapidTriggerLowerLimitMm: limit });
+                                  if (!success) {
+                                    console.error(`Failed to write rapid trigger lower limit for key ${selectedKeySettings.keyId}`);
+                                  }
+                                }}
+                                className="w-full"
+                              />
+                              <p className="text-xs text-gray-500 mt-1">
+                                Outside of the zone the key uses the actuation and release points.
+                              </p>
+                            </div>
                           </div>
                         )}
                       </div>
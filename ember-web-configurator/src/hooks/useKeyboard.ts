@@ -10,7 +10,7 @@ import {
   getPairedEmberSerialDevices,
   setupSerialEventListeners
 } from '../utils/emberProtocol';
-import { EmberProtocol, readAllKeyMappings as protocolReadAllKeyMappings, readAllKeySwitchConfigs as protocolReadAllKeySwitchConfigs, readKeyMapping as protocolReadKeyMapping, readKeySwitchConfig as protocolReadKeySwitchConfig, resetConfiguration as protocolResetConfiguration, saveConfiguration as protocolSaveConfiguration, writeKeyMapping as protocolWriteKeyMapping, writeKeySwitchConfig as protocolWriteKeySwitchConfig, type KeySwitchConfigData, type KeySwitchConfigUpdate } from '../utils/emberProtocol';
+import { EmberProtocol, clearUsageStats as protocolClearUsageStats, readUsageStats as protocolReadUsageStats, readAllKeyMappings as protocolReadAllKeyMappings, readAllKeySwitchConfigs as protocolReadAllKeySwitchConfigs, readKeyMapping as protocolReadKeyMapping, readKeySwitchConfig as protocolReadKeySwitchConfig, resetConfiguration as protocolResetConfiguration, saveConfiguration as protocolSaveConfiguration, writeKeyMapping as protocolWriteKeyMapping, writeKeySwitchConfig as protocolWriteKeySwitchConfig, type KeyUsageData, type KeySwitchConfigData, type KeySwitchConfigUpdate } from '../utils/emberProtocol';
 
 export interface KeyboardState {
   isSupported: boolean;
@@ -44,6 +44,9 @@ export interface UseKeyboardReturn extends KeyboardState {
   startCalibration: () => Promise<boolean>;
   stopCalibration: () => Promise<boolean>;
   enterDfuMode: () => Promise<boolean>;
+  // Usage statistics
+  readUsageStats: () => Promise<KeyUsageData[] | null>;
+  clearUsageStats: () => Promise<boolean>;
 }
 
 export function useKeyboard(): UseKeyboardReturn {
@@ -384,6 +387,20 @@ export function useKeyboard(): UseKeyboardReturn {
     }
   }, []);
 
+  const readUsageStatsCallback = useCallback(async (): Promise<KeyUsageData[] | null> => {
+    if (!protocolRef.current) {
+      throw new Error('No protocol instance available');
+    }
+    return await protocolReadUsageStats(protocolRef.current);
+  }, []);
+
+  const clearUsageStatsCallback = useCallback(async (): Promise<boolean> => {
+    if (!protocolRef.current) {
+      throw new Error('No protocol instance available');
+    }
+    return await protocolClearUsageStats(protocolRef.current);
+  }, []);
+
   return {
     ...state,
     connect,
@@ -403,5 +420,7 @@ export function useKeyboard(): UseKeyboardReturn {
     startCalibration: startCalibrationCallback,
     stopCalibration: stopCalibrationCallback,
     enterDfuMode: enterDfuModeCallback,
+    readUsageStats: readUsageStatsCallback,
+    clearUsageStats: clearUsageStatsCallback,
   };
 }
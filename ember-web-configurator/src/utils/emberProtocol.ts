@@ -74,6 +74,28 @@ export interface EmberResponse {
   data?: Uint8Array; // Only for read operations
 }
 
+/**
+ * Snapshot pushed by the device for a subscription
+ */
+export interface EmberPushFrame {
+  address: number;
+  tick: number; // HAL tick of the device (ms)
+  keyMask: number;
+  values: Map<number, Uint8Array>; // key index -> value bytes
+}
+
+// Status byte of the frames pushed for a subscription
+const PUSH_STATUS = 0x02;
+const SUBSCRIBE_COMMAND = 0x02;
+// Backoff of the push frame reader after an error
+const PUSH_RETRY_MIN_MS = 10;
+const PUSH_RETRY_MAX_MS = 1000;
+
+interface EmberSubscription {
+  stride: number;
+  listener: (frame: EmberPushFrame) => void;
+}
+
 /**
  * Web Serial APIがサポートされているかチェック
  */
@@ -249,6 +271,10 @@ export class EmberProtocol {
   private isTransactionActive = false;
   private responseTimeout = 3000; // 1 second timeout
   private transactionQueue: Promise<void> = Promise.resolve();
+  // Bytes received after the last delimiter, the start of the next frame
+  private rxPending: number[] = [];
+  private subscriptions = new Map<number, EmberSubscription>();
+  private isPushPumpRunning = false;
 
   constructor(port: SerialPort) {
     this.port = port;
@@ -423,28 +449,49 @@ export class EmberProtocol {
   }
 
   /**
-   * Wait for response with timeout
+   * Wait for response with timeout. Frames pushed for subscriptions are
+   * dispatched on the way.
    */
   private async waitForResponse(): Promise<EmberResponse> {
+    const deadline = Date.now() + this.responseTimeout;
+    for (;;) {
+      const payload = await this.readFrame(deadline - Date.now());
+      if (!this.dispatchPushFrame(payload)) {
+        return this.parseResponse(payload);
+      }
+    }
+  }
+
+  /**
+   * Read one COBS frame with timeout and decode it
+   */
+  private async readFrame(timeoutMs: number): Promise<Uint8Array> {
     if (!this.port.readable) {
       throw new Error('Port is not readable');
     }
 
     // 各リクエストごとに新しいリーダーを作成（グローバルリーダーを使わない）
     const reader = this.port.readable.getReader();
-    
+    let timer: ReturnType<typeof setTimeout> | undefined;
+
     try {
       const timeoutPromise = new Promise<never>((_, reject) => {
-        setTimeout(() => reject(new Error('Response timeout')), this.responseTimeout);
+        timer = setTimeout(() => reject(new Error('Response timeout')), Math.max(timeoutMs, 0));
       });
 
       const readPromise = this.readResponseData(reader);
       
       const responseData = await Promise.race([readPromise, timeoutPromise]);
       
-      return this.parseResponse(responseData);
+      const payload = cobsDecode(responseData);
+      if (!payload) {
+        console.error('Failed to decode COBS packet');
+        throw new Error('Failed to decode COBS packet');
+      }
+      return payload;
     } catch (error) {
       // タイムアウトや他のエラーが発生した場合、確実にリーダーをキャンセル
+      this.rxPending = [];
       try {
         await reader.cancel();
       } catch (cancelError) {
@@ -452,6 +499,7 @@ export class EmberProtocol {
       }
       throw error;
     } finally {
+      clearTimeout(timer);
       // 必ずリーダーをリリース
       try {
         reader.releaseLock();
@@ -462,13 +510,34 @@ export class EmberProtocol {
   }
 
   /**
-   * Read response data from stream until delimiter
+   * Read response data from stream until delimiter. Bytes after the
+   * delimiter are kept for the next frame.
    */
   private async readResponseData(reader: ReadableStreamDefaultReader<Uint8Array>): Promise<Uint8Array> {
     const buffer: number[] = [];
-    let foundDelimiter = false;
     const maxBufferSize = 1024; // Prevent excessive memory usage
-    let totalBytesRead = 0;
+
+    const take = (bytes: ArrayLike<number>): boolean => {
+      for (let i = 0; i < bytes.length; i++) {
+        const byte = bytes[i];
+        if (byte === 0x00) {
+          // Found delimiter - packet complete
+          this.rxPending = Array.from(bytes).slice(i + 1);
+          return true;
+        }
+        buffer.push(byte);
+
+        // Prevent buffer overflow
+        if (buffer.length > maxBufferSize) {
+          throw new Error('Response packet too large');
+        }
+      }
+      return false;
+    };
+
+    const pending = this.rxPending;
+    this.rxPending = [];
+    let foundDelimiter = take(pending);
 
     while (!foundDelimiter) {
       const result = await reader.read();
@@ -477,49 +546,53 @@ export class EmberProtocol {
         throw new Error('Stream ended unexpectedly');
       }
       
-      totalBytesRead += result.value.length;
-      
-      // Debug logging for each chunk
-      const hex = Array.from(result.value).map(b => '0x' + b.toString(16).padStart(2, '0')).join(' ');
-      
-      // Process each byte
-      for (let i = 0; i < result.value.length; i++) {
-        const byte = result.value[i];
-        if (byte === 0x00) {
-          // Found delimiter - packet complete
-          foundDelimiter = true;
-          break;
-        } else {
-          buffer.push(byte);
-          
-          // Prevent buffer overflow
-          if (buffer.length > maxBufferSize) {
-            throw new Error('Response packet too large');
-          }
-        }
-      }
+      foundDelimiter = take(result.value);
     }
     
     const responseData = new Uint8Array(buffer);
     
-    // Debug logging for complete packet
-    const completeHex = Array.from(responseData).map(b => '0x' + b.toString(16).padStart(2, '0')).join(' ');
-    console.log(`RX [${responseData.length}]: ${completeHex}`);
+    // Debug logging for complete packet (pushed frames are too frequent)
+    if (!this.subscriptions.size) {
+      const completeHex = Array.from(responseData).map(b => '0x' + b.toString(16).padStart(2, '0')).join(' ');
+      console.log(`RX [${responseData.length}]: ${completeHex}`);
+    }
     
     return responseData;
   }
 
   /**
-   * Parse response according to Ember protocol
+   * Hand a pushed frame to the listener of its subscription
+   * @returns false if the payload is not a pushed frame
    */
-  private parseResponse(rawData: Uint8Array): EmberResponse {
-    // Decode COBS directly (response doesn't have extra command byte)
-    const payload = cobsDecode(rawData);
-    if (!payload) {
-      console.error('Failed to decode COBS packet');
-      throw new Error('Failed to decode COBS packet');
+  private dispatchPushFrame(payload: Uint8Array): boolean {
+    if (payload.length < 12 || payload[0] !== PUSH_STATUS) {
+      return false;
     }
 
+    const address = (payload[1] << 8) | payload[2];
+    const subscription = this.subscriptions.get(address);
+    if (!subscription) {
+      return true;
+    }
+
+    const view = new DataView(payload.buffer, payload.byteOffset, payload.byteLength);
+    const keyMask = view.getUint32(8, true);
+    const values = new Map<number, Uint8Array>();
+    let offset = 12;
+    for (let key = 0; key < 32; key++) {
+      if ((keyMask >>> key) & 1) {
+        values.set(key, payload.slice(offset, offset + subscription.stride));
+        offset += subscription.stride;
+      }
+    }
+    subscription.listener({ address, tick: view.getUint32(4, true), keyMask, values });
+    return true;
+  }
+
+  /**
+   * Parse response according to Ember protocol
+   */
+  private parseResponse(payload: Uint8Array): EmberResponse {
     if (payload.length < 4) {
       console.error(`Response packet too short: ${payload.length} bytes`);
       throw new Error('Response packet too short');
@@ -575,6 +648,105 @@ export class EmberProtocol {
     }
   }
 
+  /**
+   * Subscribe to a per-key region (e.g. 0x2000 push distance, 0x2100 raw ADC,
+   * 0x4040 noise). The device pushes the values of the keys in keyMask every
+   * intervalMs until unsubscribed. A region has one subscription, a new one
+   * replaces the previous.
+   * @param stride Bytes per key
+   * @returns unsubscribe function, or null if the device refused
+   */
+  async subscribe(
+    address: number,
+    stride: number,
+    keyMask: number,
+    intervalMs: number,
+    listener: (frame: EmberPushFrame) => void
+  ): Promise<(() => Promise<void>) | null> {
+    const subscription: EmberSubscription = { stride, listener };
+    // Register first, frames may follow the response in the same chunk
+    this.subscriptions.set(address, subscription);
+    const response = await this.sendSubscribe(address, stride, keyMask, intervalMs);
+    if (!response.success) {
+      if (this.subscriptions.get(address) === subscription) {
+        this.subscriptions.delete(address);
+      }
+      return null;
+    }
+    this.startPushPump();
+
+    return async () => {
+      // Replaced by a newer subscription
+      if (this.subscriptions.get(address) !== subscription) {
+        return;
+      }
+      this.subscriptions.delete(address);
+      await this.sendSubscribe(address, 0, 0, 0);
+    };
+  }
+
+  private async sendSubscribe(
+    address: number,
+    stride: number,
+    keyMask: number,
+    intervalMs: number
+  ): Promise<EmberResponse> {
+    return this.withTransaction(async () => {
+      const packet = new Uint8Array(10);
+      packet[0] = SUBSCRIBE_COMMAND;
+      packet[1] = (address >> 8) & 0xFF;
+      packet[2] = address & 0xFF;
+      packet[3] = 6;
+      packet[4] = intervalMs;
+      packet[5] = stride;
+      new DataView(packet.buffer).setUint32(6, keyMask >>> 0, true);
+
+      await this.sendPacket(packet);
+      return await this.waitForResponse();
+    });
+  }
+
+  /**
+   * Read pushed frames while there are subscriptions. Each frame is read in
+   * its own transaction so that queries go in between. Errors are retried with
+   * a growing delay, and the pump stops for good once the port is gone.
+   */
+  private startPushPump(): void {
+    if (this.isPushPumpRunning) {
+      return;
+    }
+    this.isPushPumpRunning = true;
+
+    const pump = async () => {
+      let retryDelayMs = 0;
+      while (this.subscriptions.size > 0) {
+        try {
+          await this.withTransaction(async () => {
+            if (this.subscriptions.size > 0) {
+              this.dispatchPushFrame(await this.readFrame(this.responseTimeout));
+            }
+          });
+          retryDelayMs = 0;
+        } catch (error) {
+          // readable is null once the port is closed or lost
+          if (!this.port.readable || (error instanceof DOMException && error.name === 'NetworkError')) {
+            console.error('Push frames stopped:', error);
+            // The device drops the subscriptions with the port
+            this.subscriptions.clear();
+            break;
+          }
+          retryDelayMs = Math.min(Math.max(retryDelayMs * 2, PUSH_RETRY_MIN_MS), PUSH_RETRY_MAX_MS);
+          console.warn(`Push frame read error, retrying in ${retryDelayMs}ms:`, error);
+          await new Promise((resolve) => setTimeout(resolve, retryDelayMs));
+        }
+      }
+    };
+
+    pump().finally(() => {
+      this.isPushPumpRunning = false;
+    });
+  }
+
   /**
    * Start continuous push distance monitoring for a specific key
    */
@@ -584,53 +756,33 @@ export class EmberProtocol {
     intervalMs: number = 10  // デフォルト10ms間隔
   ): () => void {
     let monitoringActive = true;
-    let consecutiveErrors = 0;
-    const maxConsecutiveErrors = 5; // 連続エラー数の上限
-    
-    const monitor = async () => {
-      while (monitoringActive) {
-        // 前のリクエストが完全に終了するまで待機
-        if (!this.isTransactionActive) {
-          try {
-            const distance = await this.readPushDistance(keyId);
-            if (distance !== null) {
-              consecutiveErrors = 0; // 成功したらエラーカウンタをリセット
-              callback(distance);
-            } else {
-              consecutiveErrors++;
-              if (consecutiveErrors >= maxConsecutiveErrors) {
-                console.error(`Too many consecutive errors (${consecutiveErrors}) for key ${keyId}, stopping monitoring`);
-                monitoringActive = false;
-                break;
-              }
-            }
-          } catch (error) {
-            consecutiveErrors++;
-            console.error(`Push distance monitoring error for key ${keyId}:`, error);
-            if (consecutiveErrors >= maxConsecutiveErrors) {
-              console.error(`Too many consecutive errors (${consecutiveErrors}) for key ${keyId}, stopping monitoring`);
-              monitoringActive = false;
-              break;
-            }
-          }
-        } else {
-          // トランザクションが進行中の場合はスキップ
-          console.log(`Skipping push distance read for key ${keyId} - transaction in progress`);
-        }
+    let unsubscribe: (() => Promise<void>) | null = null;
 
-        await new Promise(resolve => setTimeout(resolve, intervalMs));
+    this.subscribe(0x2000, 1, 1 << keyId, intervalMs, (frame) => {
+      const value = frame.values.get(keyId);
+      if (monitoringActive && value) {
+        callback(value[0]);
       }
-    };
-
-    // Start monitoring
-    monitor().catch(error => {
+    }).then((stop) => {
+      if (!stop) {
+        console.error(`Failed to subscribe to the push distance of key ${keyId}`);
+        callback(null);
+        return;
+      }
+      unsubscribe = stop;
+      if (!monitoringActive) {
+        unsubscribe().catch(() => {});
+      }
+    }).catch((error) => {
       console.error('Push distance monitoring error:', error);
-      monitoringActive = false;
     });
 
     // Return stop function
     return () => {
       monitoringActive = false;
+      if (unsubscribe) {
+        unsubscribe().catch((error) => console.warn('Failed to unsubscribe:', error));
+      }
     };
   }
 
@@ -655,6 +807,9 @@ export class EmberProtocol {
     // グローバルリーダーは使用していないため、トランザクション状態のみリセット
     this.isTransactionActive = false;
     this.transactionQueue = Promise.resolve();
+    // The device drops the subscriptions when the port is closed
+    this.subscriptions.clear();
+    this.rxPending = [];
   }
 }
 
@@ -665,7 +820,7 @@ export class EmberProtocol {
 /**
  * Read key mapping for specific key
  */
-const KEY_CONFIG_SIZE = 5;
+const KEY_CONFIG_SIZE = 16;
 const KEY_CONFIG_BASE_ADDRESS = 0x0000;
 
 const KEY_CONFIG_OFFSETS = {
@@ -674,16 +829,45 @@ const KEY_CONFIG_OFFSETS = {
   actuationPoint: 2,
   rapidTriggerUpSensitivity: 3,
   rapidTriggerDownSensitivity: 4,
+  releasePoint: 5,
+  topDeadzone: 6,
+  bottomDeadzone: 7,
+  predictiveVelocity: 8,
+  predictiveHorizon: 9,
+  switchType: 13,
+  rapidTriggerUpperLimit: 14,
+  rapidTriggerLowerLimit: 15,
 } as const;
 
 const KEY_CONFIG_SCALE = 0.1; // Values stored in 0.1mm units
 
+// Built-in switch profiles of the firmware (switch_profile.cc)
+export const SWITCH_TYPES = [
+  { value: 0, name: 'Custom', travelMm: 4.0 },
+  { value: 1, name: 'Standard', travelMm: 4.0 },
+  { value: 2, name: 'Short, strong magnet', travelMm: 3.5 },
+  { value: 3, name: 'Low profile, weak magnet', travelMm: 3.0 },
+  { value: 4, name: 'Linear response', travelMm: 4.0 },
+] as const;
+
+export function getSwitchTravelMm(switchType: number): number {
+  return SWITCH_TYPES.find(type => type.value === switchType)?.travelMm ?? 4.0;
+}
+
 export interface KeySwitchConfigData {
   keyCode: number;
   keyType: number;
   actuationPointMm: number;
   rapidTriggerUpSensitivityMm: number;
   rapidTriggerDownSensitivityMm: number;
+  releasePointMm: number;
+  topDeadzoneMm: number;
+  bottomDeadzoneMm: number;
+  predictiveVelocity: number; // 0.1mm/sample, 0 = disabled
+  predictiveHorizon: number; // 1/4 sample
+  switchType: number;
+  rapidTriggerUpperLimitMm: number; // 0 = no limit
+  rapidTriggerLowerLimitMm: number; // 0 = no limit
 }
 
 export interface KeySwitchConfigUpdate {
@@ -692,6 +876,16 @@ export interface KeySwitchConfigUpdate {
   actuationPointMm?: number;
   rapidTriggerUpSensitivityMm?: number;
   rapidTriggerDownSensitivityMm?: number;
+  releasePointMm?: number;
+  topDeadzoneMm?: number;
+  bottomDeadzoneMm?: number;
+  predictiveVelocity?: number;
+  predictiveHorizon?: number;
+  // Loads the curve, deadzones and rapid trigger defaults of the switch on the
+  // device. Write it alone and read the config back.
+  switchType?: number;
+  rapidTriggerUpperLimitMm?: number;
+  rapidTriggerLowerLimitMm?: number;
 }
 
 const clamp = (value: number, min: number, max: number): number => {
@@ -726,6 +920,14 @@ export async function readKeySwitchConfig(protocol: EmberProtocol, keyId: number
       actuationPointMm: data[KEY_CONFIG_OFFSETS.actuationPoint] * KEY_CONFIG_SCALE,
       rapidTriggerUpSensitivityMm: data[KEY_CONFIG_OFFSETS.rapidTriggerUpSensitivity] * KEY_CONFIG_SCALE,
       rapidTriggerDownSensitivityMm: data[KEY_CONFIG_OFFSETS.rapidTriggerDownSensitivity] * KEY_CONFIG_SCALE,
+      releasePointMm: data[KEY_CONFIG_OFFSETS.releasePoint] * KEY_CONFIG_SCALE,
+      topDeadzoneMm: data[KEY_CONFIG_OFFSETS.topDeadzone] * KEY_CONFIG_SCALE,
+      bottomDeadzoneMm: data[KEY_CONFIG_OFFSETS.bottomDeadzone] * KEY_CONFIG_SCALE,
+      predictiveVelocity: data[KEY_CONFIG_OFFSETS.predictiveVelocity],
+      predictiveHorizon: data[KEY_CONFIG_OFFSETS.predictiveHorizon],
+      switchType: data[KEY_CONFIG_OFFSETS.switchType],
+      rapidTriggerUpperLimitMm: data[KEY_CONFIG_OFFSETS.rapidTriggerUpperLimit] * KEY_CONFIG_SCALE,
+      rapidTriggerLowerLimitMm: data[KEY_CONFIG_OFFSETS.rapidTriggerLowerLimit] * KEY_CONFIG_SCALE,
     };
   } catch (error) {
     console.error(`Failed to read key config for key ${keyId}:`, error);
@@ -773,6 +975,46 @@ export async function writeKeySwitchConfig(protocol: EmberProtocol, keyId: numbe
       writeOperations.push({ address: keyConfigAddress(keyId, KEY_CONFIG_OFFSETS.rapidTriggerDownSensitivity), value: rawValue });
     }
 
+    if (updates.releasePointMm !== undefined) {
+      const rawValue = clamp(Math.round(updates.releasePointMm / KEY_CONFIG_SCALE), 0, 0xFF);
+      writeOperations.push({ address: keyConfigAddress(keyId, KEY_CONFIG_OFFSETS.releasePoint), value: rawValue });
+    }
+
+    if (updates.topDeadzoneMm !== undefined) {
+      const rawValue = clamp(Math.round(updates.topDeadzoneMm / KEY_CONFIG_SCALE), 0, 0xFF);
+      writeOperations.push({ address: keyConfigAddress(keyId, KEY_CONFIG_OFFSETS.topDeadzone), value: rawValue });
+    }
+
+    if (updates.bottomDeadzoneMm !== undefined) {
+      const rawValue = clamp(Math.round(updates.bottomDeadzoneMm / KEY_CONFIG_SCALE), 0, 0xFF);
+      writeOperations.push({ address: keyConfigAddress(keyId, KEY_CONFIG_OFFSETS.bottomDeadzone), value: rawValue });
+    }
+
+    if (updates.predictiveVelocity !== undefined) {
+      const rawValue = clamp(Math.round(updates.predictiveVelocity), 0, 0xFF);
+      writeOperations.push({ address: keyConfigAddress(keyId, KEY_CONFIG_OFFSETS.predictiveVelocity), value: rawValue });
+    }
+
+    if (updates.predictiveHorizon !== undefined) {
+      const rawValue = clamp(Math.round(updates.predictiveHorizon), 0, 0xFF);
+      writeOperations.push({ address: keyConfigAddress(keyId, KEY_CONFIG_OFFSETS.predictiveHorizon), value: rawValue });
+    }
+
+    if (updates.rapidTriggerUpperLimitMm !== undefined) {
+      const rawValue = clamp(Math.round(updates.rapidTriggerUpperLimitMm / KEY_CONFIG_SCALE), 0, 0xFF);
+      writeOperations.push({ address: keyConfigAddress(keyId, KEY_CONFIG_OFFSETS.rapidTriggerUpperLimit), value: rawValue });
+    }
+
+    if (updates.rapidTriggerLowerLimitMm !== undefined) {
+      const rawValue = clamp(Math.round(updates.rapidTriggerLowerLimitMm / KEY_CONFIG_SCALE), 0, 0xFF);
+      writeOperations.push({ address: keyConfigAddress(keyId, KEY_CONFIG_OFFSETS.rapidTriggerLowerLimit), value: rawValue });
+    }
+
+    if (updates.switchType !== undefined) {
+      const rawValue = clamp(Math.round(updates.switchType), 0, 0xFF);
+      writeOperations.push({ address: keyConfigAddress(keyId, KEY_CONFIG_OFFSETS.switchType), value: rawValue });
+    }
+
     if (writeOperations.length === 0) {
       return true;
     }
@@ -812,6 +1054,176 @@ export async function resetConfiguration(protocol: EmberProtocol): Promise<boole
   }
 }
 
+const DEVICE_CONFIG_ADDRESS = 0x1800;
+const DEVICE_CONFIG_OFFSETS = {
+  backgroundCalibration: 0,
+  pollingInterval: 5,
+  reportMode: 6,
+  keepAliveInterval: 7,
+} as const;
+
+export async function readBackgroundCalibration(protocol: EmberProtocol): Promise<boolean | null> {
+  try {
+    const response = await protocol.readQuery(DEVICE_CONFIG_ADDRESS + DEVICE_CONFIG_OFFSETS.backgroundCalibration, 1);
+    if (!response.success || !response.data) {
+      return null;
+    }
+    return response.data[0] !== 0;
+  } catch (error) {
+    console.error('Failed to read background calibration:', error);
+    return null;
+  }
+}
+
+export async function writeBackgroundCalibration(protocol: EmberProtocol, enabled: boolean): Promise<boolean> {
+  try {
+    const response = await protocol.writeQuery(
+      DEVICE_CONFIG_ADDRESS + DEVICE_CONFIG_OFFSETS.backgroundCalibration,
+      new Uint8Array([enabled ? 0x01 : 0x00]),
+    );
+    return response.success;
+  } catch (error) {
+    console.error('Failed to write background calibration:', error);
+    return false;
+  }
+}
+
+// Keyboard endpoint polling interval in ms. Applied after saving and reconnecting.
+export async function readPollingInterval(protocol: EmberProtocol): Promise<number | null> {
+  try {
+    const response = await protocol.readQuery(DEVICE_CONFIG_ADDRESS + DEVICE_CONFIG_OFFSETS.pollingInterval, 1);
+    if (!response.success || !response.data) {
+      return null;
+    }
+    return Math.max(response.data[0], 1);
+  } catch (error) {
+    console.error('Failed to read polling interval:', error);
+    return null;
+  }
+}
+
+export async function writePollingInterval(protocol: EmberProtocol, intervalMs: number): Promise<boolean> {
+  try {
+    const response = await protocol.writeQuery(
+      DEVICE_CONFIG_ADDRESS + DEVICE_CONFIG_OFFSETS.pollingInterval,
+      new Uint8Array([Math.min(Math.max(Math.round(intervalMs), 1), 255)]),
+    );
+    return response.success;
+  } catch (error) {
+    console.error('Failed to write polling interval:', error);
+    return false;
+  }
+}
+
+// true: NKRO interface, false: 6KRO interface. Switches immediately.
+export async function readNkroEnabled(protocol: EmberProtocol): Promise<boolean | null> {
+  try {
+    const response = await protocol.readQuery(DEVICE_CONFIG_ADDRESS + DEVICE_CONFIG_OFFSETS.reportMode, 1);
+    if (!response.success || !response.data) {
+      return null;
+    }
+    return response.data[0] !== 0;
+  } catch (error) {
+    console.error('Failed to read report mode:', error);
+    return null;
+  }
+}
+
+export async function writeNkroEnabled(protocol: EmberProtocol, enabled: boolean): Promise<boolean> {
+  try {
+    const response = await protocol.writeQuery(
+      DEVICE_CONFIG_ADDRESS + DEVICE_CONFIG_OFFSETS.reportMode,
+      new Uint8Array([enabled ? 0x01 : 0x00]),
+    );
+    return response.success;
+  } catch (error) {
+    console.error('Failed to write report mode:', error);
+    return false;
+  }
+}
+
+// Resend the current report after this many ms without one, 0 disables it.
+export async function readKeepAliveInterval(protocol: EmberProtocol): Promise<number | null> {
+  try {
+    const response = await protocol.readQuery(DEVICE_CONFIG_ADDRESS + DEVICE_CONFIG_OFFSETS.keepAliveInterval, 2);
+    if (!response.success || !response.data || response.data.length < 2) {
+      return null;
+    }
+    return response.data[0] | (response.data[1] << 8);
+  } catch (error) {
+    console.error('Failed to read keep-alive interval:', error);
+    return null;
+  }
+}
+
+export async function writeKeepAliveInterval(protocol: EmberProtocol, intervalMs: number): Promise<boolean> {
+  try {
+    const value = Math.min(Math.max(Math.round(intervalMs), 0), 0xFFFF);
+    const response = await protocol.writeQuery(
+      DEVICE_CONFIG_ADDRESS + DEVICE_CONFIG_OFFSETS.keepAliveInterval,
+      new Uint8Array([value & 0xFF, value >> 8]),
+    );
+    return response.success;
+  } catch (error) {
+    console.error('Failed to write keep-alive interval:', error);
+    return false;
+  }
+}
+
+const USAGE_STATS_ADDRESS = 0x6000;
+const USAGE_STATS_CONTROL_ADDRESS = 0x3009;
+const KEY_USAGE_SIZE = 36; // u32 actuations + 8 x u16 dwell + 8 x u16 depth
+const USAGE_BUCKETS = 8;
+const USAGE_READ_CHUNK = KEY_USAGE_SIZE * 6; // Reads are limited to 255 bytes
+
+export interface KeyUsageData {
+  actuations: number;
+  // Bucket i counts presses held shorter than 16ms << i (the last one: longer)
+  dwellHistogram: number[];
+  // Bucket i counts presses whose deepest point was in [i * 0.5mm, (i + 1) * 0.5mm)
+  depthHistogram: number[];
+}
+
+export async function readUsageStats(protocol: EmberProtocol): Promise<KeyUsageData[] | null> {
+  try {
+    const bytes = new Uint8Array(KEY_USAGE_SIZE * 32);
+    for (let offset = 0; offset < bytes.length; offset += USAGE_READ_CHUNK) {
+      const length = Math.min(USAGE_READ_CHUNK, bytes.length - offset);
+      const response = await protocol.readQuery(USAGE_STATS_ADDRESS + offset, length);
+      if (!response.success || !response.data || response.data.length < length) {
+        return null;
+      }
+      bytes.set(response.data.subarray(0, length), offset);
+    }
+    const view = new DataView(bytes.buffer);
+    const usage: KeyUsageData[] = [];
+    for (let keyId = 0; keyId < 32; keyId++) {
+      const base = keyId * KEY_USAGE_SIZE;
+      const dwellHistogram: number[] = [];
+      const depthHistogram: number[] = [];
+      for (let i = 0; i < USAGE_BUCKETS; i++) {
+        dwellHistogram.push(view.getUint16(base + 4 + i * 2, true));
+        depthHistogram.push(view.getUint16(base + 4 + USAGE_BUCKETS * 2 + i * 2, true));
+      }
+      usage.push({ actuations: view.getUint32(base, true), dwellHistogram, depthHistogram });
+    }
+    return usage;
+  } catch (error) {
+    console.error('Failed to read usage statistics:', error);
+    return null;
+  }
+}
+
+export async function clearUsageStats(protocol: EmberProtocol): Promise<boolean> {
+  try {
+    const response = await protocol.writeQuery(USAGE_STATS_CONTROL_ADDRESS, new Uint8Array([0x00]));
+    return response.success;
+  } catch (error) {
+    console.error('Failed to clear usage statistics:', error);
+    return false;
+  }
+}
+
 export async function readKeyMapping(protocol: EmberProtocol, keyId: number): Promise<number | null> {
   try {
     const address = keyConfigAddress(keyId, KEY_CONFIG_OFFSETS.keyCode);
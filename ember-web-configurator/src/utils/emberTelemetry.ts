@@ -0,0 +1,264 @@
+// Ember telemetry over WebHID
+// The vendor defined HID interface streams the travel of all keys after each
+// scan, without the request/response round trips of the serial protocol.
+
+declare global {
+  interface Navigator {
+    hid?: {
+      requestDevice(options: { filters: HIDDeviceFilter[] }): Promise<HIDDevice[]>;
+      getDevices(): Promise<HIDDevice[]>;
+    };
+  }
+}
+
+interface HIDDeviceFilter {
+  vendorId?: number;
+  productId?: number;
+  usagePage?: number;
+  usage?: number;
+}
+
+interface HIDInputReportEvent extends Event {
+  readonly device: HIDDevice;
+  readonly reportId: number;
+  readonly data: DataView;
+}
+
+export interface HIDDevice {
+  readonly opened: boolean;
+  readonly productName: string;
+  open(): Promise<void>;
+  close(): Promise<void>;
+  sendReport(reportId: number, data: BufferSource): Promise<void>;
+  addEventListener(type: 'inputreport', listener: (event: HIDInputReportEvent) => void): void;
+  removeEventListener(type: 'inputreport', listener: (event: HIDInputReportEvent) => void): void;
+}
+
+const EMBER_VENDOR_ID = 0xCAFE;
+const TELEMETRY_USAGE_PAGE = 0xFF00;
+const TELEMETRY_REPORT_SIZE = 64;
+const TRAVEL_FRAME = 0x01;
+const RAW_FRAME = 0x02;
+const RAW_FRAME_HEADER_SIZE = 12;
+const COMMAND_STOP = 0x00;
+const COMMAND_START = 0x01;
+const COMMAND_START_RAW = 0x02;
+
+export interface TelemetryFrame {
+  // Scan number, a gap means scans that were not streamed
+  scan: number;
+  // Time of the scan in us since startup (wraps)
+  timestampUs: number;
+  // Bit i = key i is pressed
+  pressed: number;
+  // Travel of each key in 0.1mm
+  travel: Uint8Array;
+}
+
+export interface TelemetryRawSample {
+  scan: number;
+  // Keys whose value at this scan is known, bit i = key i
+  known: number;
+  // Raw ADC value of each key
+  values: Uint16Array;
+}
+
+/**
+ * Decoder of the delta encoded raw frames (TelemetryRawFrame of the firmware).
+ * Keeps the values of the previous record, so feed it every frame in order.
+ */
+export class TelemetryRawDecoder {
+  private values = new Uint16Array(32);
+  private known = 0;
+  // Sequence number expected next, null before the first frame
+  private nextSequence: number | null = null;
+
+  /**
+   * @returns the samples of the frame, or null if it is malformed. The decoder
+   * then waits for keyframes again.
+   */
+  decode(data: DataView): TelemetryRawSample[] | null {
+    const samples = this.decodeFrame(data);
+    if (!samples) {
+      this.known = 0;
+    }
+    return samples;
+  }
+
+  private decodeFrame(data: DataView): TelemetryRawSample[] | null {
+    if (data.byteLength < RAW_FRAME_HEADER_SIZE || data.getUint8(0) !== RAW_FRAME) {
+      return null;
+    }
+    const count = data.getUint8(1);
+    const end = RAW_FRAME_HEADER_SIZE + data.getUint8(2);
+    if (end > data.byteLength || end > TELEMETRY_REPORT_SIZE) {
+      return null;
+    }
+    // A lost frame took deltas with it, the values are stale until keyframes
+    const sequence = data.getUint8(3);
+    if (this.nextSequence !== null && sequence !== this.nextSequence) {
+      this.known = 0;
+    }
+    this.nextSequence = (sequence + 1) & 0xFF;
+    let scan = data.getUint32(4, true);
+    let pos = RAW_FRAME_HEADER_SIZE;
+    const samples: TelemetryRawSample[] = [];
+
+    for (let r = 0; r < count; r++) {
+      if (pos + 5 > end) {
+        return null;
+      }
+      const flags = data.getUint8(pos);
+      const bitmap = data.getUint32(pos + 1, true);
+      pos += 5;
+      // bit0 keyframe, bit1 keyframe half, bit2~6 scans since the previous record,
+      // bit7 the changed keys that did not fit follow
+      let skipped = 0;
+      if (flags & 0x80) {
+        if (pos + 4 > end) {
+          return null;
+        }
+        skipped = data.getUint32(pos, true);
+        pos += 4;
+      }
+      const keyframeMask = !(flags & 0x01) ? 0 : (flags & 0x02) ? 0xFFFF0000 : 0x0000FFFF;
+      scan = (scan + ((flags >> 2) & 0x1F)) >>> 0;
+
+      for (let i = 0; i < 32; i++) {
+        if (!((bitmap >>> i) & 1)) {
+          continue;
+        }
+        let value = 0;
+        for (let shift = 0; ; shift += 7) {
+          if (pos >= end || shift > 28) {
+            return null;
+          }
+          const byte = data.getUint8(pos++);
+          value += (byte & 0x7F) * 2 ** shift;
+          if (!(byte & 0x80)) {
+            break;
+          }
+        }
+        if ((keyframeMask >>> i) & 1) {
+          this.values[i] = value;
+          this.known = (this.known | (1 << i)) >>> 0;
+        } else {
+          // zigzag: 0, 1, 2, 3... -> 0, -1, 1, -2...
+          const delta = value % 2 === 0 ? value / 2 : -(value + 1) / 2;
+          this.values[i] = this.values[i] + delta;
+        }
+      }
+      // The skipped keys hold the value of an older scan
+      samples.push({ scan, known: (this.known & ~skipped) >>> 0, values: this.values.slice() });
+    }
+    return pos === end ? samples : null;
+  }
+}
+
+export function isWebHidSupported(): boolean {
+  return 'hid' in navigator && navigator.hid !== undefined;
+}
+
+/**
+ * Ask the user for the telemetry interface of an Ember keyboard.
+ */
+export async function requestTelemetryDevice(): Promise<HIDDevice | null> {
+  if (!isWebHidSupported()) {
+    throw new Error('WebHID is not supported in this browser');
+  }
+  const devices = await navigator.hid!.requestDevice({
+    filters: [{ vendorId: EMBER_VENDOR_ID, usagePage: TELEMETRY_USAGE_PAGE }],
+  });
+  if (devices.length === 0) {
+    return null;
+  }
+  const device = devices[0];
+  if (!device.opened) {
+    await device.open();
+  }
+  return device;
+}
+
+export function parseTelemetryFrame(data: DataView): TelemetryFrame | null {
+  if (data.byteLength < 16 || data.getUint8(0) !== TRAVEL_FRAME) {
+    return null;
+  }
+  const keyCount = data.getUint8(1);
+  if (data.byteLength < 16 + keyCount) {
+    return null;
+  }
+  return {
+    scan: data.getUint32(4, true),
+    timestampUs: data.getUint32(8, true),
+    pressed: data.getUint32(12, true),
+    travel: new Uint8Array(data.buffer, data.byteOffset + 16, keyCount).slice(),
+  };
+}
+
+/**
+ * Start streaming. Returns a function that stops it.
+ * @param intervalMs minimum interval between frames. A frame carries a new
+ * scan, so 1 streams every scan (250 frames/s).
+ */
+export async function startTelemetry(
+  device: HIDDevice,
+  intervalMs: number,
+  onFrame: (frame: TelemetryFrame) => void,
+): Promise<() => Promise<void>> {
+  const listener = (event: HIDInputReportEvent) => {
+    const frame = parseTelemetryFrame(event.data);
+    if (frame) {
+      onFrame(frame);
+    }
+  };
+  device.addEventListener('inputreport', listener);
+
+  const start = new Uint8Array(TELEMETRY_REPORT_SIZE);
+  start[0] = COMMAND_START;
+  start[1] = Math.min(Math.max(Math.round(intervalMs), 1), 255);
+  await device.sendReport(0, start);
+
+  return async () => {
+    device.removeEventListener('inputreport', listener);
+    const stop = new Uint8Array(TELEMETRY_REPORT_SIZE);
+    stop[0] = COMMAND_STOP;
+    try {
+      await device.sendReport(0, stop);
+    } catch (error) {
+      console.error('Failed to stop telemetry:', error);
+    }
+  };
+}
+
+/**
+ * Stream the raw ADC values of every scan. Each frame carries all scans since
+ * the previous one. Returns a function that stops it.
+ */
+export async function startRawTelemetry(
+  device: HIDDevice,
+  onSamples: (samples: TelemetryRawSample[]) => void,
+): Promise<() => Promise<void>> {
+  const decoder = new TelemetryRawDecoder();
+  const listener = (event: HIDInputReportEvent) => {
+    const samples = decoder.decode(event.data);
+    if (samples && samples.length > 0) {
+      onSamples(samples);
+    }
+  };
+  device.addEventListener('inputreport', listener);
+
+  const start = new Uint8Array(TELEMETRY_REPORT_SIZE);
+  start[0] = COMMAND_START_RAW;
+  await device.sendReport(0, start);
+
+  return async () => {
+    device.removeEventListener('inputreport', listener);
+    const stop = new Uint8Array(TELEMETRY_REPORT_SIZE);
+    stop[0] = COMMAND_STOP;
+    try {
+      await device.sendReport(0, stop);
+    } catch (error) {
+      console.error('Failed to stop telemetry:', error);
+    }
+  };
+}
@@ -99,6 +99,38 @@ export const KEY_MAPPINGS: KeyMapping[] = [
   { code: 0xE6, shortName: 'ALT', fullName: 'Right Alt', category: 'Modifier' },
   { code: 0xE7, shortName: 'WIN', fullName: 'Right Windows', category: 'Modifier' },
 
+  // Media
+  { code: 0xA8, shortName: 'MUTE', fullName: 'Mute', category: 'Media' },
+  { code: 0xA9, shortName: 'VOL+', fullName: 'Volume Up', category: 'Media' },
+  { code: 0xAA, shortName: 'VOL-', fullName: 'Volume Down', category: 'Media' },
+  { code: 0xAB, shortName: 'NEXT', fullName: 'Next Track', category: 'Media' },
+  { code: 0xAC, shortName: 'PREV', fullName: 'Previous Track', category: 'Media' },
+  { code: 0xAD, shortName: 'STOP', fullName: 'Media Stop', category: 'Media' },
+  { code: 0xAE, shortName: 'PLAY', fullName: 'Play/Pause', category: 'Media' },
+  { code: 0xAF, shortName: 'MSEL', fullName: 'Media Select', category: 'Media' },
+  { code: 0xB0, shortName: 'EJCT', fullName: 'Eject', category: 'Media' },
+  { code: 0xBB, shortName: 'FF', fullName: 'Fast Forward', category: 'Media' },
+  { code: 0xBC, shortName: 'REW', fullName: 'Rewind', category: 'Media' },
+
+  // Application
+  { code: 0xB1, shortName: 'MAIL', fullName: 'Mail', category: 'Application' },
+  { code: 0xB2, shortName: 'CALC', fullName: 'Calculator', category: 'Application' },
+  { code: 0xB3, shortName: 'MYPC', fullName: 'My Computer', category: 'Application' },
+  { code: 0xB4, shortName: 'WSCH', fullName: 'WWW Search', category: 'Application' },
+  { code: 0xB5, shortName: 'WHOM', fullName: 'WWW Home', category: 'Application' },
+  { code: 0xB6, shortName: 'WBAK', fullName: 'WWW Back', category: 'Application' },
+  { code: 0xB7, shortName: 'WFWD', fullName: 'WWW Forward', category: 'Application' },
+  { code: 0xB8, shortName: 'WSTP', fullName: 'WWW Stop', category: 'Application' },
+  { code: 0xB9, shortName: 'WREF', fullName: 'WWW Refresh', category: 'Application' },
+  { code: 0xBA, shortName: 'WFAV', fullName: 'WWW Favorites', category: 'Application' },
+  { code: 0xBD, shortName: 'BRI+', fullName: 'Brightness Up', category: 'Application' },
+  { code: 0xBE, shortName: 'BRI-', fullName: 'Brightness Down', category: 'Application' },
+
+  // System
+  { code: 0xA5, shortName: 'PWR', fullName: 'System Power', category: 'System' },
+  { code: 0xA6, shortName: 'SLEP', fullName: 'System Sleep', category: 'System' },
+  { code: 0xA7, shortName: 'WAKE', fullName: 'System Wake', category: 'System' },
+
   // Special
   { code: 0x00, shortName: 'NONE', fullName: 'No Key', category: 'Special' },
 ];
@@ -79,16 +79,18 @@ extern "C" {
 //------------- CLASS -------------//
 #define CFG_TUD_CDC 1
 #define CFG_TUD_MSC 0
-#define CFG_TUD_HID 1
+#define CFG_TUD_HID 5
 #define CFG_TUD_MIDI 0
 #define CFG_TUD_VENDOR 0
 
 // HID buffer size Should be sufficient to hold ID (if any) + Data
-#define CFG_TUD_HID_EP_BUFSIZE 8
+#define CFG_TUD_HID_EP_BUFSIZE 64
 
 // CDC FIFO size of TX and RX
+// TX holds a whole pushed frame of the configurator (up to 262 bytes), a
+// frame is pushed only when it fits.
 #define CFG_TUD_CDC_RX_BUFSIZE (TUD_OPT_HIGH_SPEED ? 512 : 64)
-#define CFG_TUD_CDC_TX_BUFSIZE (TUD_OPT_HIGH_SPEED ? 512 : 64)
+#define CFG_TUD_CDC_TX_BUFSIZE 512
 
 // CDC Endpoint transfer buffer size, more is faster
 #define CFG_TUD_CDC_EP_BUFSIZE (TUD_OPT_HIGH_SPEED ? 512 : 64)
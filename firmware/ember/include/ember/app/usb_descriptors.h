@@ -25,13 +25,31 @@
 #ifndef USB_DESCRIPTORS_H_
 #define USB_DESCRIPTORS_H_
 
+#include <stdint.h>
+
 enum
 {
   REPORT_ID_KEYBOARD = 1,
   REPORT_ID_MOUSE,
   REPORT_ID_CONSUMER_CONTROL,
   REPORT_ID_GAMEPAD,
+  REPORT_ID_SYSTEM_CONTROL,
   REPORT_ID_COUNT
 };
 
+// HID interfaces in the order of the configuration descriptor
+enum
+{
+  HID_INSTANCE_KEYBOARD = 0,
+  HID_INSTANCE_NKRO,
+  HID_INSTANCE_TELEMETRY,
+  HID_INSTANCE_CONTROL,
+  HID_INSTANCE_GAMEPAD,
+  HID_INSTANCE_COUNT
+};
+
+// Set bInterval (ms) of the keyboard endpoints. Call before tusb_init(), the
+// host reads it at enumeration. 0 is treated as 1.
+void usb_set_hid_polling_interval(uint8_t interval);
+
 #endif /* USB_DESCRIPTORS_H_ */
@@ -24,16 +24,57 @@ class Configurator {
   void Start();
   void Init();
   void Task();
+  /**
+   * @brief Push the snapshots of the subscribed regions that are due. Called
+   * from the main loop.
+   */
+  void Publish();
 
  private:
   Configurator() = default;
 
+  /**
+   * @brief Subscription to a per-key region. The values of the keys in
+   * key_mask are pushed every interval ms until unsubscribed.
+   */
+  struct Subscription {
+    uint16_t address;
+    // Bytes per key
+    uint8_t stride;
+    // ms, 0 = unused
+    uint8_t interval;
+    uint32_t key_mask;
+    uint32_t last_tick;
+  };
+  static constexpr uint8_t kMaxSubscriptions = 4;
+  // Data of a push frame before the values: tick, key mask
+  static constexpr uint8_t kPushHeaderSize = 8;
+
   static constexpr size_t kBufSize = 1024;
   etl::queue<uint8_t, 2048> rx_queue_;
   void ProcessCompleteMessage();
+  /**
+   * @brief Read any readable region of the address map.
+   * @return false if the range is outside of all regions.
+   */
+  bool ReadRegion(uint16_t address, uint8_t length, uint8_t* dst);
+  /**
+   * @brief Add, replace or (interval = 0) remove the subscription of the
+   * address.
+   * @return false if the region can not be pushed.
+   */
+  bool Subscribe(uint16_t address, uint8_t interval, uint8_t stride,
+                 uint32_t key_mask);
+  /**
+   * @brief Read a per-key uint16 statistic region (little endian).
+   * @return false if the range is outside of the region.
+   */
+  bool ReadKeyStats(uint16_t address, uint8_t length, uint16_t base,
+                    uint16_t (*getter)(const KeySwitchStats&), uint8_t* dst);
 
   Keyboard* keyboard_;
   Config* config_;
+  Subscription subscriptions_[kMaxSubscriptions] = {};
 };
 }  // namespace ember
 #endif  // EMBER_COMMUNICATION_CONFIGRATOR_H_
@@ -0,0 +1,98 @@
+#ifndef EMBER_COMMUNICATION_TELEMETRY_H_
+#define EMBER_COMMUNICATION_TELEMETRY_H_
+
+#include <cstdint>
+
+#include "ember/commnication/telemetry_codec.h"
+#include "ember/keyboard/keyboard.h"
+
+namespace ember {
+// TelemetryFrame::type
+constexpr uint8_t kTelemetryTravelFrame = 0x01;
+
+/**
+ * @brief Input report of the telemetry interface: the state of all keys
+ * after a scan.
+ * @note 64 bytes
+ */
+struct TelemetryFrame {
+  uint8_t type = kTelemetryTravelFrame;
+  uint8_t key_count = 32;
+  uint16_t reserved0 = 0;
+  // Number of the scan the frame was taken from. A gap means scans that were
+  // not streamed.
+  uint32_t scan = 0;
+  // Time of the scan in us since startup (wraps every 71 minutes)
+  uint32_t timestamp_us = 0;
+  // Bit i = key i is pressed
+  uint32_t pressed = 0;
+  // Travel of each key in 0.1mm
+  uint8_t travel[32] = {};
+  uint8_t reserved1[16] = {};
+} __attribute__((packed));
+
+static_assert(sizeof(TelemetryFrame) == 64, "TelemetryFrame must be 64 bytes");
+
+/**
+ * @brief Stream TelemetryFrame on the vendor defined HID interface.
+ * The host starts and stops the stream with an output report:
+ * [0x01, interval (ms)] starts it, [0x00] stops it. A frame is only sent
+ * for a new scan, so the rate is bounded by the 250Hz scan (TIM17).
+ * [0x02] streams the raw ADC values of every scan as TelemetryRawFrame
+ * instead. A frame is sent whenever the endpoint is free and carries all
+ * scans since the previous one.
+ */
+class Telemetry {
+ public:
+  // Singleton
+  Telemetry(const Telemetry&) = delete;
+  Telemetry& operator=(const Telemetry&) = delete;
+  static Telemetry* GetInstance() {
+    static Telemetry instance;
+    return &instance;
+  }
+
+ public:
+  static constexpr uint8_t kCommandStop = 0x00;
+  static constexpr uint8_t kCommandStart = 0x01;
+  static constexpr uint8_t kCommandStartRaw = 0x02;
+
+  void SetKeyboard(Keyboard* keyboard) { keyboard_ = keyboard; }
+  /**
+   * @brief Send a frame if streaming, a new scan is available, the interval
+   * elapsed and the endpoint is free. Called from the main loop and when the
+   * previous frame was read.
+   */
+  void Task();
+  /**
+   * @brief Handle an output report from the host.
+   */
+  void OnOutputReport(const uint8_t* buffer, uint16_t size);
+
+ private:
+  Telemetry() = default;
+  /**
+   * @brief Time in us since startup, from the cycle counter. Must be called
+   * more often than the cycle counter wraps.
+   */
+  uint32_t Micros();
+  void RawTask(uint32_t now_us);
+  /**
+   * @brief Send the frame being encoded. The encoder starts over with
+   * keyframes if it can not be sent.
+   */
+  void SendRawFrame();
+
+  Keyboard* keyboard_ = nullptr;
+  bool streaming_ = false;
+  // Streaming TelemetryRawFrame
+  bool raw_ = false;
+  TelemetryEncoder encoder_;
+  uint8_t interval_ = 1;
+  uint32_t last_frame_tick_ = 0;
+  uint32_t last_scan_ = 0;
+  uint32_t micros_ = 0;
+  uint32_t micros_cycles_ = 0;
+};
+}  // namespace ember
+#endif  // EMBER_COMMUNICATION_TELEMETRY_H_
@@ -0,0 +1,120 @@
+#ifndef EMBER_COMMUNICATION_TELEMETRY_CODEC_H_
+#define EMBER_COMMUNICATION_TELEMETRY_CODEC_H_
+
+#include <cstdint>
+
+namespace ember {
+// TelemetryRawFrame::type
+constexpr uint8_t kTelemetryRawFrame = 0x02;
+
+/**
+ * @brief Input report of the telemetry interface carrying the raw ADC values
+ * of consecutive scans, delta encoded against the previous record.
+ * Record:
+ * - flags: bit0 keyframe, bit1 keyframe half (0 = Key0~15, 1 = Key16~31),
+ *   bit2~6 scans since the previous record of the frame (0 for the first),
+ *   bit7 some changed keys did not fit
+ * - uint32 LE bitmap of the keys in the record
+ * - uint32 LE bitmap of the changed keys that did not fit, if bit7 is set.
+ *   The next record carries their change.
+ * - a varint per key in the bitmap, in key order: the value for the keys of
+ *   the keyframe half, zigzag(value - previous value) for the others.
+ * Other keys did not change.
+ * @note 64 bytes
+ */
+struct TelemetryRawFrame {
+  uint8_t type = kTelemetryRawFrame;
+  uint8_t record_count = 0;
+  // Bytes of records
+  uint8_t length = 0;
+  // Incremented every frame (wraps), a gap means the host lost a frame.
+  uint8_t sequence = 0;
+  // Scan number and time (us) of the first record
+  uint32_t scan = 0;
+  uint32_t timestamp_us = 0;
+  uint8_t records[52] = {};
+} __attribute__((packed));
+
+static_assert(sizeof(TelemetryRawFrame) == 64,
+              "TelemetryRawFrame must be 64 bytes");
+
+/**
+ * @brief Pack the raw values of consecutive scans into TelemetryRawFrame.
+ * Every kKeyframeInterval records half of the keys are sent as is, so that a
+ * decoder that missed frames resynchronizes within 2 * kKeyframeInterval
+ * records.
+ */
+class TelemetryEncoder {
+ public:
+  static constexpr uint8_t kKeyframeInterval = 32;
+
+  /**
+   * @brief Start over. The next two records are keyframes. The frame sequence
+   * goes on, so that a decoder sees the frames that were dropped.
+   */
+  void Reset();
+  /**
+   * @brief Append the values of a scan to the frame.
+   * @return false if the record does not fit, Finish() the frame and append
+   * it again. A record always fits into an empty frame. Changed keys that do
+   * not fit even then are listed as skipped and sent in the next record.
+   */
+  bool Append(uint32_t scan, uint32_t timestamp_us, const uint16_t* values);
+  bool IsEmpty() const { return frame_.record_count == 0; }
+  /**
+   * @brief Take the frame and start a new one.
+   */
+  TelemetryRawFrame Finish();
+
+ private:
+  // Scans since the previous record that fit into the flags
+  static constexpr uint8_t kMaxScanGap = 31;
+
+  TelemetryRawFrame frame_;
+  uint16_t previous_[32] = {};
+  uint32_t last_scan_ = 0;
+  uint8_t records_since_keyframe_ = 0;
+  uint8_t next_half_ = 0;
+  // Keyframe halves to send before any delta
+  uint8_t pending_keyframes_ = 2;
+  // Sequence number of the next frame
+  uint8_t sequence_ = 0;
+};
+
+/**
+ * @brief Values of all keys after a decoded record.
+ */
+struct TelemetrySample {
+  uint32_t scan;
+  // Keys whose value at this scan is known, bit i = key i. Keys the record
+  // skipped are not.
+  uint32_t known;
+  uint16_t values[32];
+};
+
+/**
+ * @brief Decode TelemetryRawFrame back into the values of each scan.
+ */
+class TelemetryDecoder {
+ public:
+  // Upper bound of records in a frame (5 bytes per record at least)
+  static constexpr uint8_t kMaxRecords = sizeof(TelemetryRawFrame::records) / 5;
+
+  /**
+   * @brief Decode a frame.
+   * @param samples kMaxRecords samples
+   * @return number of samples, or -1 if the frame is malformed. The decoder
+   * then waits for keyframes again, as it does after a gap in the frame
+   * sequence.
+   */
+  int Decode(const uint8_t* data, uint16_t size, TelemetrySample* samples);
+
+ private:
+  uint16_t values_[32] = {};
+  uint32_t known_ = 0;
+  // Sequence number expected next, valid after the first frame
+  uint8_t next_sequence_ = 0;
+  bool has_sequence_ = false;
+};
+}  // namespace ember
+#endif  // EMBER_COMMUNICATION_TELEMETRY_CODEC_H_
@@ -4,9 +4,43 @@
 #include <cstdint>
 
 namespace ember {
+// "EB" + layout marker. Flash images without this magic are the legacy
+// (version 1) layout which had no header at all.
+constexpr uint16_t kConfigMagic = 0xEB01;
+/**
+ * @brief Config layout version
+ * 1: 5 bytes KeySwitchConfig, no header
+ * 2: 16 bytes KeySwitchConfig, release_point
+ * 3: top_deadzone, bottom_deadzone
+ * 4: predictive_velocity, predictive_horizon
+ * 5: filter_alpha, filter_beta
+ * 6: DeviceConfig, background_calibration
+ * 7: KeySwitchCurve
+ * 8: SocdGroupConfig
+ * 9: DynamicKeystrokeConfig, dynamic_keystroke_slot
+ * 10: inverted_keys
+ * 11: switch_type
+ * 12: rappid_trigger_upper_limit, rappid_trigger_lower_limit
+ * 13: polling_interval
+ * 14: report_mode
+ * 15: keep_alive_interval
+ * 16: GamepadAxisConfig
+ */
+constexpr uint16_t kConfigVersion = 16;
+
+/**
+ * @brief ConfigHeader
+ * @note 4 bytes
+ */
+struct ConfigHeader {
+  uint16_t magic = kConfigMagic;
+  uint16_t version = kConfigVersion;
+} __attribute__((packed));
+
 /**
  * @brief KeySwitchConfig
- * @note 5 bytes
+ * @note 16 bytes. Fields are added in place of reserved bytes so that the
+ * per-key stride of the configurator address map stays stable.
  */
 struct KeySwitchConfig {
   uint8_t key_code = 0;
@@ -14,6 +48,7 @@ struct KeySwitchConfig {
    * @brief
    * 0: ThresholdKey
    * 1: RappidTrigger
+   * 2: DynamicKeystroke
    */
   uint8_t key_type = 0;
   // actuation point in 0.1mm unit
@@ -25,10 +60,43 @@ struct KeySwitchConfig {
   // 最も浅く押したときの位置からどれだけ離れたらトリガーを発動するか。0.1mm単位。
   // How far away from the shallowest position to trigger. 0.1mm unit.
   uint8_t rappid_trigger_down_sensivity = 2;
+  // (v2) release point in 0.1mm unit.
+  // actuation_point より浅くするとヒステリシスになる。
+  // Set shallower than actuation_point to get hysteresis.
+  uint8_t release_point = 8;
+  // (v3) Positions within this range from the top read as 0. 0.1mm unit.
+  uint8_t top_deadzone = 1;
+  // (v3) Positions within this range from the bottom read as full travel.
+  // 0.1mm unit.
+  uint8_t bottom_deadzone = 1;
+  // (v4) Predictive trigger
+  // 速度がこの値以上のとき、次のサンプルまでに閾値を越えると予測されたらトリガーする。
+  // 0.1mm/sample単位。0で無効。
+  // Fire when the key is expected to cross the threshold before the next
+  // sample and moves at least this fast. 0.1mm/sample unit. 0 disables it.
+  uint8_t predictive_velocity = 0;
+  // How far ahead the position is projected. 1/4 sample unit.
+  uint8_t predictive_horizon = 4;
+  // (v5) Alpha-beta filter gains in 1/256 unit. filter_alpha = 0 disables it.
+  uint8_t filter_alpha = 0;
+  uint8_t filter_beta = 0;
+  // (v9) Index of Config::dynamic_keystrokes used when key_type is 2.
+  uint8_t dynamic_keystroke_slot = 0;
+  // (v11) Built-in switch profile (see switch_profile.h). Selecting one
+  // writes its curve, deadzones and rapid trigger defaults. 0: Custom.
+  // スイッチの種類。変更するとカーブ、デッドゾーン、ラピッドトリガー設定を書き換える。
+  uint8_t switch_type = 0;
+  // (v12) RappidTrigger active zone in 0.1mm. Outside of it the key acts as a
+  // ThresholdKey. 0 disables the limit.
+  // ラピッドトリガーが有効な範囲。範囲外では通常の閾値判定になる。0で制限なし。
+  uint8_t rappid_trigger_upper_limit = 0;
+  uint8_t rappid_trigger_lower_limit = 0;
 } __attribute__((packed));
 
 /**
  * @brief KeySwitchCalibrationData
+ * Values are oriented so that the ADC value falls as the key is pressed, see
+ * DeviceConfig::inverted_keys.
  * @note 4 bytes
  */
 struct KeySwitchCalibrationData {
@@ -36,14 +104,173 @@ struct KeySwitchCalibrationData {
   uint16_t min_value = 1000;
 } __attribute__((packed));
 
+// Number of knots of KeySwitchCurve. Knot i is at i / 8 of the travel of the
+// switch type, i * 0.5mm for 4.0mm switches.
+constexpr uint8_t kCurveKnots = 9;
+// Normalized depth of the bottom
+constexpr uint16_t kCurveScale = 65535;
+
+/**
+ * @brief ADC value vs travel curve
+ * knots[i] is the normalized depth (max_value - value) / (max_value -
+ * min_value) * kCurveScale at knot i. Travel is interpolated linearly
+ * between knots.
+ * 各ノット(ストロークの1/8ごと)における正規化したADC値。間は線形補間される。
+ * @note 18 bytes
+ */
+struct KeySwitchCurve {
+  // Logarithmic curve (a = 200) of the default calibration range
+  uint16_t knots[kCurveKnots] = {0,     3216,  7260,  12344, 18735,
+                                 26770, 36871, 49570, kCurveScale};
+} __attribute__((packed));
+
+// Number of DynamicKeystrokeConfig slots and actions per slot
+constexpr uint8_t kDynamicKeystrokeSlots = 8;
+constexpr uint8_t kDynamicKeystrokeActions = 4;
+
+/**
+ * @brief Dynamic Keystroke action
+ * 押し込みが press_point を越えると key_code を押し、release_point 以下に
+ * 戻ると離す。
+ * key_code is pressed when the key goes past press_point and released when it
+ * comes back to release_point.
+ * @note 4 bytes
+ */
+struct DynamicKeystrokeAction {
+  // 0 = unused
+  uint8_t key_code = 0;
+  // 0.1mm unit
+  uint8_t press_point = 10;
+  // 0.1mm unit, clamped to press_point
+  uint8_t release_point = 8;
+  /**
+   * @brief
+   * bit0: Release the actions with a shallower press_point while this action
+   * is pressed. (e.g. walk -> sprint)
+   */
+  uint8_t flags = 0;
+} __attribute__((packed));
+
+/**
+ * @brief Dynamic Keystroke (multiple actions at different depths of a key)
+ * @note 16 bytes
+ */
+struct DynamicKeystrokeConfig {
+  DynamicKeystrokeAction actions[kDynamicKeystrokeActions];
+} __attribute__((packed));
+
+// Number of SOCD groups
+constexpr uint8_t kSocdGroups = 4;
+
+/**
+ * @brief SOCD (Simultaneous Opposing Cardinal Directions) group
+ * グループ内のキーが同時に押されたとき、policyに従って1つだけを有効にする。
+ * When keys of a group are pressed at the same time, only one of them (or
+ * none) is reported according to the policy.
+ * @note 8 bytes
+ */
+struct SocdGroupConfig {
+  // Bit i = key i. A key belongs to the first group that contains it.
+  uint32_t key_mask = 0;
+  /**
+   * @brief
+   * 0: Disabled
+   * 1: Last input priority
+   * 2: First input priority
+   * 3: Neutral (none of them)
+   * 4: Deepest travel priority
+   */
+  uint8_t policy = 0;
+  uint8_t reserved[3] = {};
+} __attribute__((packed));
+
+// Number of gamepad axes: X, Y, Z, Rx, Ry, Rz
+constexpr uint8_t kGamepadAxes = 6;
+// Number of knots of GamepadAxisConfig::curve
+constexpr uint8_t kGamepadCurveKnots = 9;
+
+/**
+ * @brief Analog gamepad axis driven by the travel of keys
+ * positive_key のストロークで軸を正の方向へ、negative_key で負の方向へ動かす。
+ * negative_key がない場合はトリガーのように、離した状態が最小、底打ちが最大になる。
+ * The travel of positive_key moves the axis to the positive side and the
+ * travel of negative_key to the negative side (e.g. A/D as a stick). Without
+ * negative_key the axis goes from the minimum at rest to the maximum when
+ * bottomed out, like a trigger.
+ * @note 16 bytes
+ */
+struct GamepadAxisConfig {
+  // Key index + 1, 0: unused
+  uint8_t positive_key = 0;
+  uint8_t negative_key = 0;
+  // Travel up to inner_deadzone reads as rest, travel beyond full travel -
+  // outer_deadzone reads as full. 1/256 of the full travel.
+  // この範囲のストロークはそれぞれ0、最大として扱う。ストローク全体の1/256単位。
+  uint8_t inner_deadzone = 8;
+  uint8_t outer_deadzone = 8;
+  // Response curve. Output at knot i (i / 8 of the travel between the
+  // deadzones) in 1/255 of the full scale, interpolated linearly.
+  // 応答カーブ。各ノットにおける出力(1/255単位)。
+  uint8_t curve[kGamepadCurveKnots] = {0,   32,  64,  96, 128,
+                                       159, 191, 223, 255};
+  /**
+   * @brief
+   * bit0: Invert the axis
+   */
+  uint8_t flags = 0;
+  uint8_t reserved[2] = {};
+} __attribute__((packed));
+
+/**
+ * @brief Settings shared by all keys
+ * @note 16 bytes
+ */
+struct DeviceConfig {
+  // (v6) 1: Track the rest and bottom values while the keyboard is in use and
+  // save them to flash when the keyboard is idle.
+  // キーを使用中にキャリブレーション値を追従させ、アイドル時にフラッシュへ保存する。
+  uint8_t background_calibration = 1;
+  // (v10) Bit i = key i. Set when calibration finds that the ADC value of the
+  // key rises as it is pressed (flipped magnet or sensor). The ADC values of
+  // these keys are inverted (4095 - value) before anything else.
+  // 磁石やセンサーの向きが逆で、押すとADC値が上がるキー。キャリブレーションで検出される。
+  uint32_t inverted_keys = 0;
+  // (v13) bInterval of the keyboard endpoint in ms (1: 1000Hz). Read by the
+  // host at enumeration, takes effect after saving and reconnecting.
+  // キーボードエンドポイントのポーリング間隔(ms)。保存後に再接続すると反映される。
+  uint8_t polling_interval = 1;
+  // (v14) 0: 6KRO on the keyboard interface, 1: NKRO on the NKRO interface.
+  // Takes effect immediately, the keys held are released on the old one.
+  // 0: 6キーロールオーバー、1: Nキーロールオーバー。すぐに切り替わる。
+  uint8_t report_mode = 1;
+  // (v15) Reports are sent only when they change. Some hosts (KVMs) expect
+  // them periodically, send the current one again after this many ms without
+  // a report. 0 disables it.
+  // 変化がない場合も、この間隔(ms)でレポートを再送する。0で無効。
+  uint16_t keep_alive_interval = 0;
+  uint8_t reserved[7] = {};
+} __attribute__((packed));
+
 /**
  * @brief Config
- * @note 288 bytes
+ * @note 1492 bytes
  */
 struct Config {
-  KeySwitchConfig key_switch_configs[32]; // 160 bytes
+  ConfigHeader header;  // 4 bytes
+  KeySwitchConfig key_switch_configs[32]; // 512 bytes
   KeySwitchCalibrationData key_switch_calibration_data[32]; // 128 bytes
+  DeviceConfig device_config; // 16 bytes
+  KeySwitchCurve key_switch_curves[32]; // 576 bytes
+  SocdGroupConfig socd_groups[kSocdGroups]; // 32 bytes
+  DynamicKeystrokeConfig dynamic_keystrokes[kDynamicKeystrokeSlots]; // 128 bytes
+  GamepadAxisConfig gamepad_axes[kGamepadAxes]; // 96 bytes
 } __attribute__((packed));
+
+static_assert(sizeof(KeySwitchConfig) == 16, "KeySwitchConfig must be 16 bytes");
+static_assert(sizeof(DeviceConfig) == 16, "DeviceConfig must be 16 bytes");
+static_assert(sizeof(GamepadAxisConfig) == 16,
+              "GamepadAxisConfig must be 16 bytes");
+static_assert(sizeof(Config) % 2 == 0, "Config is programmed in half words");
 }  // namespace ember
 
 #endif  // EMBER_KEYBOARD_CONFIG_H_
@@ -0,0 +1,55 @@
+#ifndef EMBER_KEYBOARD_FILTER_H_
+#define EMBER_KEYBOARD_FILTER_H_
+
+#include <cstdint>
+
+namespace ember {
+/**
+ * @brief Fixed point alpha-beta filter for a 12bit ADC value.
+ * @note The state tracks value and velocity, so a fast stroke is followed
+ * with much less lag than a moving average of the same noise reduction.
+ * script/filter_benchmark.py mirrors this implementation.
+ */
+class AlphaBetaFilter {
+ public:
+  /**
+   * @brief Filter a sample.
+   * @param value 12bit ADC value.
+   * @param alpha position gain in 1/256 unit. 0 bypasses the filter.
+   * @param beta velocity gain in 1/256 unit.
+   * @return filtered 12bit ADC value.
+   */
+  uint16_t Update(uint16_t value, uint8_t alpha, uint8_t beta) {
+    int32_t measured = static_cast<int32_t>(value) << kFractionBits;
+    if (alpha == 0 || !initialized_) {
+      // Keep the state primed so that enabling the filter does not glitch.
+      position_ = measured;
+      velocity_ = 0;
+      initialized_ = true;
+      return value;
+    }
+    int32_t predicted = position_ + velocity_;
+    int32_t residual = measured - predicted;
+    position_ = predicted + ((alpha * residual) >> 8);
+    velocity_ += (beta * residual) >> 8;
+    if (position_ < 0) {
+      position_ = 0;
+    } else if (position_ > kMaxPosition) {
+      position_ = kMaxPosition;
+    }
+    return (position_ + (1 << (kFractionBits - 1))) >> kFractionBits;
+  }
+
+ private:
+  static constexpr int kFractionBits = 8;
+  static constexpr int32_t kMaxPosition = 4095 << kFractionBits;
+
+  // Q8 ADC value
+  int32_t position_ = 0;
+  // Q8 ADC value per sample
+  int32_t velocity_ = 0;
+  bool initialized_ = false;
+};
+}  // namespace ember
+
+#endif  // EMBER_KEYBOARD_FILTER_H_
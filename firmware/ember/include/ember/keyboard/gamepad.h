@@ -0,0 +1,59 @@
+#ifndef EMBER_KEYBOARD_GAMEPAD_H_
+#define EMBER_KEYBOARD_GAMEPAD_H_
+
+#include <cstdint>
+
+#include "ember/keyboard/config.h"
+
+namespace ember {
+/**
+ * @brief Input report of the gamepad interface
+ * @note 12 bytes
+ */
+struct GamepadReport {
+  // X, Y, Z, Rx, Ry, Rz, -kAxisMax~kAxisMax
+  int16_t axes[kGamepadAxes] = {};
+} __attribute__((packed));
+
+/**
+ * @brief Turn the travel of the keys into gamepad axes following
+ * GamepadAxisConfig: deadzones, response curve, then one key (trigger) or a
+ * pair of keys (bipolar) per axis.
+ * @note Runs once per scan from the main loop. Only the keys mapped to an
+ * axis are read, see GetMappedKeys().
+ */
+class Gamepad {
+ public:
+  static constexpr int16_t kAxisMax = 32767;
+
+  /**
+   * @brief Update the axes.
+   * @param travels travel of each key, 0~kCurveScale
+   * (KeySwitchBase::GetLastTravel()). Only the mapped keys are read.
+   * @return true if the report changed.
+   */
+  bool Update(const GamepadAxisConfig (&axes)[kGamepadAxes],
+              const uint16_t (&travels)[32]);
+  const GamepadReport& GetReport() const { return report_; }
+  /**
+   * @brief Bitmap of the keys mapped to an axis, bit i = key i.
+   */
+  static uint32_t GetMappedKeys(const GamepadAxisConfig (&axes)[kGamepadAxes]);
+
+ private:
+  /**
+   * @brief Apply the deadzones and the curve of the axis to a travel.
+   * @return 0~kCurveScale
+   */
+  static uint16_t Shape(const GamepadAxisConfig& axis, uint16_t travel);
+  /**
+   * @brief Travel of the key (index + 1, 0: unused) after Shape().
+   */
+  static uint16_t KeyValue(const GamepadAxisConfig& axis, uint8_t key,
+                           const uint16_t (&travels)[32]);
+
+  GamepadReport report_;
+};
+}  // namespace ember
+
+#endif  // EMBER_KEYBOARD_GAMEPAD_H_
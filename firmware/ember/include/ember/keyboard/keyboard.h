@@ -1,22 +1,122 @@
 #ifndef EMBER_KEYBOARD_KEYBOARD_H_
 #define EMBER_KEYBOARD_KEYBOARD_H_
 
+#include <algorithm>
+#include <atomic>
+
 #include "SEGGER_RTT.h"
 #include "ember/keyboard/config.h"
+#include "ember/keyboard/filter.h"
+#include "ember/keyboard/gamepad.h"
 #include "ember/keyboard/keycodes.h"
 #include "ember/keyboard/keyswitch.h"
+#include "ember/keyboard/report_builder.h"
+#include "ember/keyboard/sensor_health.h"
+#include "ember/keyboard/socd.h"
+#include "ember/keyboard/usage_stats.h"
+#include "ember/utils/spsc_queue.h"
 #include "main.h"
 #include "tusb.h"
 
 namespace ember {
+/**
+ * @brief Press or release edge of a key
+ */
+struct KeyEvent {
+  // CycleCounter::Now() when the edge was detected
+  uint32_t timestamp;
+  uint8_t index;
+  bool pressed;
+};
+
+/**
+ * @brief Counters of the key event queue
+ * @note 12 bytes
+ */
+struct KeyEventStats {
+  // Edges detected by the scan
+  uint32_t edges = 0;
+  // Edges dropped because the queue was full
+  uint32_t overflows = 0;
+  // Largest number of queued events
+  uint16_t high_water_mark = 0;
+  // Number of queued events when read
+  uint16_t depth = 0;
+} __attribute__((packed));
+
+/**
+ * @brief Latency from the detection of an edge to the completion of the
+ * report that carried it, in us. Measured on the first edge of each report.
+ * @note 16 bytes
+ */
+struct ReportLatencyStats {
+  uint32_t samples = 0;
+  uint32_t min_us = 0;
+  uint32_t max_us = 0;
+  // Sum of the samples. Halved together with samples before it overflows.
+  uint32_t total_us = 0;
+} __attribute__((packed));
+
+/**
+ * @brief Counters of the HID report transmission
+ * @note 12 bytes
+ */
+struct HidTxStats {
+  // Reports handed to the endpoint
+  uint32_t transfers = 0;
+  // Completed transfers during which edges were queued. The edges went out
+  // together in the next report.
+  uint32_t coalesced = 0;
+  // Transfers that never completed (bus reset) and were given up
+  uint32_t stalls = 0;
+} __attribute__((packed));
+
 class Keyboard {
  public:
   Keyboard(Config& config);
 
   /**
-   * @brief Send a HID report to the host.
+   * @brief Work after each scan, from the timer interrupt. Recreates the key
+   * switches whose settings changed.
    */
   void Update();
+  /**
+   * @brief Build the HID report from the latest key state and send it if the
+   * endpoint is free, on the keyboard (6KRO) or the NKRO interface following
+   * DeviceConfig::report_mode. Called from the main loop and when the host
+   * has taken the previous report, never from an interrupt.
+   * @note A report is sent only when it changed, or when nothing was sent for
+   * DeviceConfig::keep_alive_interval. A change made while the endpoint is
+   * busy stays pending and is sent once when it frees. The media and system
+   * control reports follow the same rule on their own interface, and so does
+   * the gamepad report, updated once per scan.
+   */
+  void SendReport();
+  /**
+   * @brief Send the current report again, e.g. after the host reset the bus.
+   */
+  void ResendReport() {
+    report_pending_ = true;
+    control_pending_ = kConsumerPending | kSystemPending;
+    gamepad_pending_ = true;
+  }
+  /**
+   * @brief Notify that the host selected the boot (true) or report protocol
+   * on the keyboard interface (tud_hid_set_protocol_cb). In boot protocol the
+   * 8 byte boot report is sent on the keyboard interface, the report protocol
+   * returns to DeviceConfig::report_mode.
+   */
+  void SetBootProtocol(bool boot);
+  /**
+   * @brief Notify that the host has read the report in flight on a HID
+   * interface (tud_hid_report_complete_cb).
+   */
+  void OnReportComplete(uint8_t instance);
+  /**
+   * @brief Background work from the main loop. Saves the background
+   * calibration and the usage statistics to flash when the keyboard is idle.
+   */
+  void Task();
   /**
    * @brief Set the ADC Value
    */
@@ -24,13 +124,210 @@ class Keyboard {
 
   void StartCalibrate();
   void StopCalibrate();
+  void StartNoiseMeasurement();
+  /**
+   * @brief Stop the noise measurement and apply the suggested deadzones.
+   */
+  void StopNoiseMeasurement();
+  /**
+   * @brief Reset the runtime statistics of all keys and the key event queue.
+   */
+  void ClearStats();
+  KeyEventStats GetKeyEventStats() const;
+  ReportLatencyStats GetReportLatencyStats() const { return latency_stats_; }
+  HidTxStats GetHidTxStats() const { return tx_stats_; }
+  /**
+   * @brief Gamepad axes as last computed.
+   */
+  const GamepadReport& GetGamepadReport() const {
+    return gamepad_.GetReport();
+  }
+  /**
+   * @brief Number of completed scans, and CycleCounter::Now() when the last
+   * one completed.
+   */
+  uint32_t GetScanCount() const { return scan_count_; }
+  uint32_t GetScanTimestamp() const { return scan_timestamp_; }
+  /**
+   * @brief Key state as seen by the scan, bit i = key i.
+   */
+  uint32_t GetPressed() const { return pressed_; }
+  /**
+   * @brief Get the SensorHealth::Fault flags of the key.
+   */
+  uint8_t GetFaultFlags(uint8_t index) const {
+    return health_[index].GetFlags();
+  }
+  /**
+   * @brief Clear the fault flags and lift the quarantine of all keys.
+   */
+  void ClearFaults();
+  const UsageStats& GetUsageStats() { return usage_.GetStats(); }
+  /**
+   * @brief Write the usage statistics to flash now if they changed.
+   */
+  void SaveUsageStats();
+  void ClearUsageStats() { usage_.Clear(); }
+  // Number of samples of the curve capture buffer
+  static constexpr uint16_t kCaptureSize = 1024;
+  /**
+   * @brief Record the raw ADC values of a key at the scan rate, for fitting
+   * its KeySwitchCurve on the host. Stops when the buffer is full.
+   */
+  void StartCurveCapture(uint8_t index);
+  void StopCurveCapture() { capture_index_ = -1; }
+  uint16_t GetCaptureCount() const { return capture_count_; }
+  uint16_t GetCaptureSample(uint16_t i) const { return capture_buffer_[i]; }
+  /**
+   * @brief Notify that the whole config including the calibration was saved.
+   */
+  void MarkCalibrationSaved();
   Config GetConfig() { return config_; }
+  /**
+   * @brief Get the last raw (unfiltered) ADC value of the key.
+   */
+  uint16_t GetRawValue(uint8_t index) const { return raw_values_[index]; }
 
   KeySwitchBase* key_switches_[32];
 
  private:
+  // Flash is written only after no key was pressed for kSaveIdleTime (ms).
+  static constexpr uint32_t kSaveIdleTime = 5000;
+  // Background calibration is saved at most once per kCalibrationSaveInterval
+  // (ms) to save flash endurance. Changes smaller than
+  // kCalibrationSaveThreshold (ADC counts) are not saved.
+  static constexpr uint32_t kCalibrationSaveInterval = 30 * 60 * 1000;
+  static constexpr uint16_t kCalibrationSaveThreshold = 8;
+  // Usage statistics are coalesced and saved at most once per
+  // kUsageSaveInterval (ms), about 2000 erases a year of continuous use.
+  static constexpr uint32_t kUsageSaveInterval = 4 * 60 * 60 * 1000;
+
+  // Storage of a key switch object. Key types are switched with placement new
+  // so that nothing is allocated at the scan rate.
+  struct alignas(ThresholdKey) alignas(RapidTriggerKey)
+      alignas(DynamicKeystrokeKey) KeySwitchStorage {
+    uint8_t data[std::max({sizeof(ThresholdKey), sizeof(RapidTriggerKey),
+                           sizeof(DynamicKeystrokeKey)})];
+  };
+
   static int8_t ChToIndex(uint8_t adc_ch, uint8_t amux_channel);
+  /**
+   * @brief (Re)create the key switch of the index for its key_type.
+   */
+  void CreateKeySwitch(uint8_t index);
+  /**
+   * @brief Queue an edge from the scan (producer side).
+   */
+  void PushKeyEvent(uint8_t index, bool pressed);
+  /**
+   * @brief Apply queued edges to the reported key state (consumer side). A
+   * key toggles at most once per report so that no edge is merged away, the
+   * rest stay queued for the next report.
+   * @return bitmap of the keys to report as pressed.
+   */
+  uint32_t DrainKeyEvents();
+  void RecordLatency(uint32_t us);
+  /**
+   * @brief Send a pending media or system control report if the endpoint of
+   * HID_INSTANCE_CONTROL is free. One report is in flight at a time, the
+   * other one follows from the completion callback.
+   */
+  void SendControlReport();
+  /**
+   * @brief Update the gamepad axes from the travel of the keys after a scan
+   * and send them if they changed and the endpoint of HID_INSTANCE_GAMEPAD is
+   * free.
+   */
+  void SendGamepadReport();
+  /**
+   * @brief Note that a report was handed to the endpoint of the instance.
+   */
+  void StartTransfer(uint8_t instance);
+  bool IsCalibrationChanged() const;
+  /**
+   * @brief XOR mask that orients the ADC value of a key so that it falls as
+   * the key is pressed: 0 or 0x0FFF (4095 - value for 12bit values).
+   */
+  uint16_t OrientationMask(uint8_t index) const {
+    return -((config_.device_config.inverted_keys >> index) & 1) & 0x0FFF;
+  }
   Config& config_;
+  KeySwitchStorage key_switch_storage_[32];
+  // key_type the key switch objects were created for
+  uint8_t key_types_[32];
+  // Keys created as DynamicKeystrokeKey, bit i = key i
+  uint32_t dynamic_keys_ = 0;
+  // switch_type whose profile was last applied
+  uint8_t switch_types_[32];
+  // Calibration data as last saved to flash.
+  KeySwitchCalibrationData saved_calibration_data_[32];
+  uint32_t last_calibration_save_tick_ = 0;
+  uint32_t last_usage_save_tick_ = 0;
+  UsageRecorder usage_;
+  // HAL tick of the last report with a pressed key. Written by Update().
+  volatile uint32_t last_active_tick_ = 0;
+  // Per-key sample state, kept contiguous and indexed like key_switches_.
+  uint16_t raw_values_[32] = {};
+  AlphaBetaFilter filters_[32];
+  SensorHealth health_[32];
+  SocdResolver socd_;
+  // Edges from the scan to the report builder
+  static constexpr size_t kKeyEventQueueSize = 64;
+  SpscQueue<KeyEvent, kKeyEventQueueSize> key_events_;
+  KeyEventStats key_event_stats_;
+  // Key state as seen by the scan, bit i = key i. Written by SetADCValue().
+  volatile uint32_t pressed_ = 0;
+  // Key state as sent to the host, bit i = key i
+  uint32_t reported_pressed_ = 0;
+  ReportBuilder report_;
+  /**
+   * @brief HID transmission state
+   * kIdle: no transfer in flight, a report is sent as soon as it changes.
+   * kInFlight: waiting for the host to read the report.
+   * kPending: in flight and edges are queued, the next report is sent from
+   * the completion callback.
+   */
+  enum class TxState : uint8_t { kIdle, kInFlight, kPending };
+  TxState tx_state_ = TxState::kIdle;
+  // HID instance of the transfer in flight
+  uint8_t tx_instance_ = 0;
+  // The host (BIOS, KVM) selected the boot protocol and reads only the
+  // keyboard interface.
+  bool boot_protocol_ = false;
+  HidTxStats tx_stats_;
+  // Set by Update() after each scan, cleared when the report is built.
+  std::atomic<bool> scanned_{false};
+  volatile uint32_t scan_count_ = 0;
+  volatile uint32_t scan_timestamp_ = 0;
+  // The report changed and was not sent yet.
+  bool report_pending_ = false;
+  // Media and system control reports: the latest values and the reports that
+  // changed and were not sent yet.
+  static constexpr uint8_t kConsumerPending = 0x01;
+  static constexpr uint8_t kSystemPending = 0x02;
+  uint16_t consumer_usage_ = 0;
+  uint8_t system_control_ = 0;
+  uint8_t control_pending_ = 0;
+  Gamepad gamepad_;
+  // Set by Update() after each scan, cleared when the axes are updated.
+  std::atomic<bool> gamepad_scanned_{false};
+  // The gamepad report changed and was not sent yet.
+  bool gamepad_pending_ = false;
+  uint32_t last_report_tick_ = 0;
+  // CycleCounter timestamp of the oldest drained edge not sent yet, and of
+  // the first edge of the report in flight.
+  uint32_t pending_edge_timestamp_ = 0;
+  bool has_pending_edge_ = false;
+  uint32_t inflight_edge_timestamp_ = 0;
+  bool has_inflight_edge_ = false;
+  ReportLatencyStats latency_stats_;
+  // Set when an edge was lost (overflow, key type change). The reported state
+  // is taken from the keys once the queue is empty.
+  std::atomic<bool> resync_{false};
+  // Curve capture. capture_index_ = -1 when not capturing.
+  volatile int8_t capture_index_ = -1;
+  volatile uint16_t capture_count_ = 0;
+  uint16_t capture_buffer_[kCaptureSize] = {};
 };
 }  // namespace ember
 
@@ -2,24 +2,49 @@
 #define EMBER_KEYBOARD_KEYSWITCH_H_
 
 #include "ember/keyboard/config.h"
+#include "ember/keyboard/switch_profile.h"
 #include "main.h"
 #include "math.h"
 
 namespace ember {
+/**
+ * @brief Runtime statistics of a key switch. Not saved to flash.
+ */
+struct KeySwitchStats {
+  // Number of presses that followed a release within kChatterWindow samples.
+  uint16_t chatter_count = 0;
+  // Deepest position seen while the key rested near the top, while measuring
+  // noise. 0.1mm unit.
+  uint8_t top_noise = 0;
+  // Distance from the bottom of the shallowest position seen while the key
+  // was held near the bottom, while measuring noise. 0.1mm unit.
+  uint8_t bottom_noise = 0;
+  // Number of edges fired by the predictive trigger.
+  uint16_t predicted_edges = 0;
+  // Number of predicted edges the measured position caught up with.
+  uint16_t confirmed_edges = 0;
+};
+
 class KeySwitchBase {
  public:
   using Config = KeySwitchConfig;
   using CalibrationData = KeySwitchCalibrationData;
+  using Curve = KeySwitchCurve;
 
-  KeySwitchBase(Config& config, CalibrationData& calibration_data)
-      : config_(config), calibration_data_(calibration_data) {}
+  KeySwitchBase(Config& config, CalibrationData& calibration_data,
+                Curve& curve)
+      : config_(config), calibration_data_(calibration_data), curve_(curve) {}
+  virtual ~KeySwitchBase() = default;
+
+  // Maximum number of key codes a key can send at once
+  static constexpr uint8_t kMaxKeyCodes = kDynamicKeystrokeActions;
 
   /**
    * @brief Update the key state.
    * @param value 12bit ADC value.
    * @return the key is pressed or not.
    */
-  virtual bool Update(uint16_t value) = 0;
+  bool Update(uint16_t value);
   /**
    * @brief Return the key is pressed or not.
    */
@@ -28,14 +53,40 @@ class KeySwitchBase {
    * @brief Get the Key Code
    */
   uint8_t GetKeyCode() const { return config_.key_code; }
+  /**
+   * @brief Get the key codes to send while the key is pressed.
+   * @return number of key codes.
+   */
+  virtual uint8_t GetKeyCodes(uint8_t (&key_codes)[kMaxKeyCodes]) const {
+    key_codes[0] = config_.key_code;
+    return 1;
+  }
   /**
    * @brief Start calibrate the key.
    */
   void StartCalibrate();
   /**
    * @brief Stop calibrate the key.
+   * @return true if the ADC value rose as the key was pressed. The calibration
+   * data is flipped to the inverted orientation (4095 - value) then, and the
+   * caller must invert the values passed to Update() from now on.
+   */
+  bool StopCalibrate();
+  /**
+   * @brief Background calibration. Slowly follow the rest value while the key
+   * is idle and extend the bottom when the key goes deeper than it.
+   * @param value 12bit ADC value, the same one passed to Update().
    */
-  void StopCalibrate();
+  void TrackCalibration(uint16_t value);
+  /**
+   * @brief Start measuring the noise near the top and the bottom.
+   */
+  void StartNoiseMeasurement();
+  /**
+   * @brief Stop measuring the noise and write the suggested deadzones to the
+   * config.
+   */
+  void StopNoiseMeasurement();
   /**
    * @brief Load the config.
    */
@@ -52,29 +103,170 @@ class KeySwitchBase {
    * @brief Get the last position in 0.1mm.
    */
   uint8_t GetLastPosition() const { return last_position_; }
+  /**
+   * @brief Get the travel of the last value at the full resolution of the
+   * curve, 0 at the top and kCurveScale at the bottom. The deadzones of the
+   * key are not applied. 0 while calibrating.
+   */
+  uint16_t GetLastTravel() const;
+  /**
+   * @brief Get the runtime statistics.
+   */
+  KeySwitchStats& GetStats() { return stats_; }
 
  protected:
+  // A press within this many samples after a release is counted as chatter.
+  static constexpr uint32_t kChatterWindow = 8;
+  // Positions within this range of the top or the bottom are used for the
+  // noise measurement. 0.1mm unit.
+  static constexpr uint8_t kNoiseZone = 5;
+  // The key is at rest when its positions stay within kNoiseStillness
+  // (0.1mm unit) for kNoiseWindow samples. Only the spread of such windows is
+  // noise, a press passing through the zones moves more than that.
+  static constexpr uint8_t kNoiseStillness = 2;
+  static constexpr uint8_t kNoiseWindow = 64;
+  // Upper limit of the suggested deadzones. 0.1mm unit.
+  static constexpr uint8_t kMaxSuggestedDeadzone = 10;
+  // A predicted edge must be confirmed within this many samples.
+  static constexpr uint8_t kPredictionWindow = 2;
+  // Background calibration
+  // The key must stay released and still (|velocity_| <= kIdleVelocity) for
+  // this many samples before the rest value is tracked.
+  static constexpr uint8_t kIdleSamples = 64;
+  static constexpr int16_t kIdleVelocity = 4;
+  // Time constants of the rest mean and deviation in 2^n samples.
+  static constexpr uint8_t kRestMeanShift = 14;
+  static constexpr uint8_t kRestDeviationShift = 10;
+  // max_value is kept this many mean deviations above the rest mean.
+  static constexpr uint8_t kRestMargin = 3;
+  // Smallest max_value - min_value the tracking may leave.
+  static constexpr uint16_t kMinCalibrationRange = 200;
+  // Consecutive readings below min_value that move the bottom.
+  static constexpr uint8_t kBottomSamples = 8;
+
+  /**
+   * @brief Update the key state from the position.
+   * @param position position in 0.1mm after the deadzones are applied.
+   * @return the key is pressed or not.
+   */
+  virtual bool UpdateState(uint8_t position) = 0;
+
   void Calibrate(uint16_t value);
-  uint8_t ADCValToDistance(uint16_t value);
+  /**
+   * @brief Convert the ADC value to the position in 0.1mm with the curve.
+   */
+  uint8_t ADCValToDistance(uint16_t value) const;
+  /**
+   * @brief Normalized depth (max_value - value) / (max_value - min_value) *
+   * kCurveScale of a value between the calibration values.
+   */
+  uint16_t ADCValToDepth(uint16_t value) const;
+  /**
+   * @brief Find the curve segment of a normalized depth above knots[0].
+   * @return i such that the depth is between knots[i - 1] and knots[i],
+   * kCurveKnots beyond the last knot. Non increasing knots are skipped.
+   */
+  uint8_t FindCurveSegment(uint16_t depth) const;
+  uint8_t ApplyDeadzone(uint8_t position) const;
+  void MeasureNoise(uint8_t position);
+  void UpdateVelocity(uint8_t position);
+  /**
+   * @brief Check whether the key is expected to cross the threshold before
+   * the next sample.
+   * @param position current position in 0.1mm.
+   * @param threshold press: position > threshold, release: position <=
+   * threshold.
+   * @param press direction of the crossing.
+   */
+  bool PredictCrossing(uint8_t position, uint8_t threshold, bool press) const;
+  /**
+   * @brief Fire an edge ahead of the threshold crossing. The edge is reverted
+   * by OnPredictionFailed() if the position does not follow.
+   */
+  void SetPredictedPressed(bool pressed, uint8_t threshold);
+  /**
+   * @brief Confirm or revert the pending predicted edge.
+   */
+  void CheckPrediction(uint8_t position);
+  /**
+   * @brief Called when a predicted edge was not confirmed.
+   */
+  virtual void OnPredictionFailed() { SetPressed(!is_pressed_); }
+  /**
+   * @brief Update is_pressed_ and track edges for statistics.
+   */
+  void SetPressed(bool pressed);
+  /**
+   * @brief Full travel of the switch type in 0.1mm.
+   */
+  uint8_t Travel() const {
+    return GetSwitchProfile(config_.switch_type).travel;
+  }
+  /**
+   * @brief Release point clamped to the actuation point.
+   */
+  uint8_t ReleasePoint() const {
+    return config_.release_point < config_.actuation_point
+               ? config_.release_point
+               : config_.actuation_point;
+  }
 
   bool is_pressed_ = false;
   bool is_calibrating_ = false;
+  // The first value seen by the calibration, the key is at rest then.
+  bool has_calibration_rest_ = false;
+  uint16_t calibration_rest_ = 0;
+  bool is_measuring_noise_ = false;
+  bool is_bottom_measured_ = false;
+  // Positions of the current still window of the noise measurement
+  uint8_t noise_window_min_ = 0;
+  uint8_t noise_window_max_ = 0;
+  uint8_t noise_window_samples_ = 0;
   Config& config_;
   CalibrationData& calibration_data_;
+  Curve& curve_;
   // Last key potision in 0.1mm
   uint8_t last_position_ = 0;
+  // Last value passed to Update(), read back by GetLastTravel()
+  uint16_t last_value_ = 0xFFFF;
+  KeySwitchStats stats_;
+  // Number of samples processed, used as a time base.
+  uint32_t sample_count_ = 0;
+  uint32_t last_release_sample_ = 0;
+  // Positions of the previous two samples in 0.1mm
+  uint8_t position_history_[2] = {0, 0};
+  // Velocity in 0.025mm/sample (positive = pressing)
+  int16_t velocity_ = 0;
+  // Background calibration state. Fixed point with 16 fractional bits,
+  // rest_mean_ = 0 until the first idle period.
+  int32_t rest_mean_ = 0;
+  int32_t rest_deviation_ = 0;
+  uint8_t idle_samples_ = 0;
+  // Readings below min_value in a row and the shallowest of them
+  uint8_t bottom_samples_ = 0;
+  uint16_t bottom_value_ = 0;
+  struct {
+    // Remaining samples to confirm. 0 = no pending prediction.
+    uint8_t samples_left = 0;
+    bool pressed = false;
+    uint8_t threshold = 0;
+  } prediction_;
 };
 
 class ThresholdKey : public KeySwitchBase {
  public:
   using KeySwitchBase::KeySwitchBase;
-  bool Update(uint16_t value) override;
+
+ protected:
+  bool UpdateState(uint8_t position) override;
 };
 
 class RapidTriggerKey : public KeySwitchBase {
  public:
   using KeySwitchBase::KeySwitchBase;
-  bool Update(uint16_t value) override;
+
+ protected:
+  bool UpdateState(uint8_t position) override;
 
  private:
   enum class State {
@@ -82,9 +274,48 @@ class RapidTriggerKey : public KeySwitchBase {
     kRapidTriggerDown,
     kRapidTriggerUp
   } state_ = State::kRest;
+  void OnPredictionFailed() override;
+  /**
+   * @brief Threshold behavior outside of the active zone, after the rapid
+   * trigger check up to the limit.
+   * @param edge the zone limit the key is beyond.
+   */
+  bool UpdateOutsideZone(uint8_t position, uint8_t edge);
+
   uint8_t peek_value_ = 0;
 };
 
+class DynamicKeystrokeKey : public KeySwitchBase {
+ public:
+  DynamicKeystrokeKey(Config& config, CalibrationData& calibration_data,
+                      Curve& curve,
+                      const DynamicKeystrokeConfig (&dynamic_keystrokes)
+                          [kDynamicKeystrokeSlots])
+      : KeySwitchBase(config, calibration_data, curve),
+        dynamic_keystrokes_(dynamic_keystrokes) {}
+
+  uint8_t GetKeyCodes(uint8_t (&key_codes)[kMaxKeyCodes]) const override;
+
+ protected:
+  bool UpdateState(uint8_t position) override;
+
+ private:
+  // DynamicKeystrokeAction::flags
+  static constexpr uint8_t kReleaseShallower = 1 << 0;
+
+  const DynamicKeystrokeConfig* Slot() const {
+    return config_.dynamic_keystroke_slot < kDynamicKeystrokeSlots
+               ? &dynamic_keystrokes_[config_.dynamic_keystroke_slot]
+               : nullptr;
+  }
+
+  const DynamicKeystrokeConfig (&dynamic_keystrokes_)[kDynamicKeystrokeSlots];
+  // Bit i = the key is past the press point of action i
+  uint8_t active_actions_ = 0;
+  // active_actions_ without the ones hidden by a deeper action
+  uint8_t reported_actions_ = 0;
+};
+
 }  // namespace ember
 
 #endif  // EMBER_KEYBOARD_KEYSWITCH_H_
@@ -0,0 +1,116 @@
+#ifndef EMBER_KEYBOARD_REPORT_BUILDER_H_
+#define EMBER_KEYBOARD_REPORT_BUILDER_H_
+
+#include <cstdint>
+
+#include "ember/keyboard/keycodes.h"
+#include "ember/keyboard/keyswitch.h"
+
+namespace ember {
+/**
+ * @brief Keep the 6KRO or the NKRO report up to date from the pressed key
+ * bitmap.
+ * @note Only the keys that changed since the last call are visited (XOR with
+ * the previous bitmap, CTZ iteration), so a frame without changes costs a
+ * few instructions. In 6KRO, key codes keep their slot while the key is held
+ * and new keys take the free slots in press order. In NKRO, every usage is a
+ * bit of the report and keys sharing a usage are reference counted.
+ * System and media control codes (KC_SYSTEM_POWER~KC_BRIGHTNESS_DOWN) are
+ * not part of the keyboard report. They are reference counted the same way
+ * and the most recently pressed one of each kind is reported.
+ */
+class ReportBuilder {
+ public:
+  static constexpr uint8_t kReportKeys = 6;
+  // NKRO report: a bit per usage 0x00-0xDF, then the modifiers (0xE0-0xE7).
+  static constexpr uint8_t kNkroReportSize = 29;
+
+  /**
+   * @brief Apply the pressed key bitmap to the report.
+   * @param pressed bitmap of the keys to report (bit i = key i).
+   * @param dynamic_keys bitmap of the keys whose codes change while they are
+   * held (Dynamic Keystroke). Their codes are compared every call.
+   * @return true if the report changed.
+   */
+  bool Update(uint32_t pressed, uint32_t dynamic_keys,
+              KeySwitchBase* const (&key_switches)[32]);
+  /**
+   * @brief Release all keys and build the 6KRO (nkro = false) or the NKRO
+   * report from the next Update().
+   */
+  void Reset(bool nkro);
+  bool IsNkro() const { return nkro_; }
+  const uint8_t* GetKeyCodes() const { return key_codes_; }
+  uint8_t GetModifier() const { return modifier_; }
+  const uint8_t* GetNkroReport() const { return nkro_report_; }
+  /**
+   * @brief Usage of the Consumer Page (0x0C) to report, 0 for none.
+   */
+  uint16_t GetConsumerUsage() const;
+  /**
+   * @brief System control to report: 1 power down, 2 sleep, 3 wake up
+   * (Generic Desktop Page 0x81-0x83), 0 for none.
+   */
+  uint8_t GetSystemControl() const {
+    return system_code_ == 0 ? 0 : system_code_ - KC_SYSTEM_POWER + 1;
+  }
+  bool IsEmpty() const {
+    return key_count_ == 0 && modifier_ == 0 && consumer_code_ == 0 &&
+           system_code_ == 0;
+  }
+
+ private:
+  /**
+   * @brief Remove the codes of a key from the report.
+   * @return true if the report changed.
+   */
+  bool RemoveKey(uint8_t index);
+  /**
+   * @brief Add the codes of a key to the report. Codes that do not fit are
+   * dropped and remembered, so that a dynamic key is not added again for
+   * them. A key none of whose codes fit is not added and is retried on the
+   * next call.
+   * @return true if the report changed.
+   */
+  bool AddKey(uint8_t index, const uint8_t* codes, uint8_t count);
+
+  /**
+   * @brief Take the system or media control code from the report.
+   */
+  void RemoveControlCode(uint8_t code);
+
+  static constexpr uint8_t kNkroUsages = (kNkroReportSize - 1) * 8;
+  static constexpr uint8_t kControlCodes =
+      KC_BRIGHTNESS_DOWN - KC_SYSTEM_POWER + 1;
+
+  static bool IsControlCode(uint8_t code) {
+    return KC_SYSTEM_POWER <= code && code <= KC_BRIGHTNESS_DOWN;
+  }
+  static bool IsSystemCode(uint8_t code) { return code <= KC_SYSTEM_WAKE; }
+
+  bool nkro_ = false;
+  // Keys whose codes are in the report
+  uint32_t reported_ = 0;
+  uint8_t key_codes_[kReportKeys] = {};
+  // Codes in key_codes_, or usages set in nkro_report_
+  uint8_t key_count_ = 0;
+  uint8_t modifier_ = 0;
+  // Codes each reported key put in the report
+  uint8_t key_report_codes_[32][KeySwitchBase::kMaxKeyCodes] = {};
+  uint8_t key_report_counts_[32] = {};
+  uint8_t key_modifiers_[32] = {};
+  // Codes each reported key asked for that did not fit
+  uint8_t key_dropped_codes_[32][KeySwitchBase::kMaxKeyCodes] = {};
+  uint8_t key_dropped_counts_[32] = {};
+  uint8_t nkro_report_[kNkroReportSize] = {};
+  // Number of reported keys holding each usage
+  uint8_t nkro_refs_[kNkroUsages] = {};
+  // Number of reported keys holding each system and media control code
+  uint8_t control_refs_[kControlCodes] = {};
+  // Reported media and system control codes, 0 for none
+  uint8_t consumer_code_ = 0;
+  uint8_t system_code_ = 0;
+};
+}  // namespace ember
+
+#endif  // EMBER_KEYBOARD_REPORT_BUILDER_H_
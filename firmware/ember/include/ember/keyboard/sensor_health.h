@@ -0,0 +1,83 @@
+#ifndef EMBER_KEYBOARD_SENSOR_HEALTH_H_
+#define EMBER_KEYBOARD_SENSOR_HEALTH_H_
+
+#include <cstdint>
+
+#include "ember/keyboard/config.h"
+
+namespace ember {
+/**
+ * @brief Health checks of a Hall sensor on its unfiltered ADC value.
+ * @note A failing key is quarantined (reads as released) until it passes all
+ * checks for kRecoverySamples. The fault flags stay set until Clear().
+ */
+class SensorHealth {
+ public:
+  enum Fault : uint8_t {
+    // Same value outside of the calibration range, or at a rail that is not
+    // the calibrated bottom, for kStuckSamples
+    kStuck = 1 << 0,
+    // Far outside of the calibration range for kOutOfRangeSamples
+    kOutOfRange = 1 << 1,
+    // Sample to sample noise at rest above kMaxNoise
+    kNoisy = 1 << 2,
+    // Repeated jumps faster than a key can move
+    kSlew = 1 << 3,
+    // Currently quarantined
+    kQuarantined = 1 << 7,
+  };
+
+  /**
+   * @brief Check a sample.
+   * @param value 12bit ADC value, oriented but not filtered.
+   * @return false while the key is quarantined.
+   */
+  bool Update(uint16_t value, const KeySwitchCalibrationData& calibration_data);
+  bool IsQuarantined() const { return flags_ & kQuarantined; }
+  /**
+   * @brief Faults seen since the last Clear() and kQuarantined.
+   */
+  uint8_t GetFlags() const { return flags_; }
+  /**
+   * @brief Clear the fault flags and lift the quarantine.
+   */
+  void Clear();
+
+ private:
+  // Sample counts at the 250Hz scan (TIM17): 11 s stuck, 5 s to recover
+  static constexpr uint16_t kStuckSamples = 2750;
+  static constexpr uint8_t kOutOfRangeSamples = 32;
+  // Out of range margin in 1/4 of the calibration range, at least
+  // kMinRangeMargin ADC counts.
+  static constexpr uint16_t kMinRangeMargin = 64;
+  // Mean |second difference| in ADC counts, measured at rest
+  static constexpr uint16_t kMaxNoise = 64;
+  static constexpr uint8_t kNoiseShift = 6;
+  // Rest band: the top 1/kRestBand of the calibration range
+  static constexpr uint8_t kRestBand = 8;
+  // Largest believable change between two samples in ADC counts: the
+  // calibration range, or kMaxSlew while it is smaller than kMinSlew.
+  static constexpr uint16_t kMaxSlew = 1024;
+  static constexpr uint16_t kMinSlew = 256;
+  // Fault after kSlewLimit jumps, one jump is forgotten every
+  // kSlewDecaySamples.
+  static constexpr uint8_t kSlewLimit = 4;
+  static constexpr uint16_t kSlewDecaySamples = 256;
+  static constexpr uint16_t kRecoverySamples = 1250;
+
+  void Fail(uint8_t fault);
+
+  uint8_t flags_ = 0;
+  bool primed_ = false;
+  uint16_t last_value_[2] = {0, 0};
+  uint16_t stuck_samples_ = 0;
+  uint8_t out_of_range_samples_ = 0;
+  // Mean |second difference| with 4 fractional bits
+  uint16_t noise_ = 0;
+  uint8_t slew_count_ = 0;
+  uint16_t slew_decay_ = 0;
+  uint16_t healthy_samples_ = 0;
+};
+}  // namespace ember
+
+#endif  // EMBER_KEYBOARD_SENSOR_HEALTH_H_
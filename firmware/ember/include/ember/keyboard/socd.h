@@ -0,0 +1,44 @@
+#ifndef EMBER_KEYBOARD_SOCD_H_
+#define EMBER_KEYBOARD_SOCD_H_
+
+#include <cstdint>
+
+#include "ember/keyboard/config.h"
+
+namespace ember {
+/**
+ * @brief Resolve SOCD groups on the pressed key bitmap.
+ * @note Runs once per scan between the key state update and the report
+ * assembly, so the winning key is reported in the same scan it is pressed.
+ */
+class SocdResolver {
+ public:
+  /**
+   * @brief Resolve the groups.
+   * @param groups SOCD group configs.
+   * @param pressed bitmap of the pressed keys (bit i = key i).
+   * @param positions positions of all keys in 0.1mm, for the deepest travel
+   * priority.
+   * @return bitmap of the keys to report.
+   */
+  uint32_t Resolve(const SocdGroupConfig (&groups)[kSocdGroups],
+                   uint32_t pressed, const uint8_t (&positions)[32]);
+
+ private:
+  enum Policy : uint8_t {
+    kDisabled = 0,
+    kLastInput = 1,
+    kFirstInput = 2,
+    kNeutral = 3,
+    kDeepest = 4,
+  };
+
+  // Pressed bitmap of the previous scan, before resolution.
+  uint32_t last_pressed_ = 0;
+  // Order of the last press of each key. Larger is newer.
+  uint32_t press_order_[32] = {};
+  uint32_t press_counter_ = 0;
+};
+}  // namespace ember
+
+#endif  // EMBER_KEYBOARD_SOCD_H_
@@ -0,0 +1,48 @@
+#ifndef EMBER_KEYBOARD_SWITCH_PROFILE_H_
+#define EMBER_KEYBOARD_SWITCH_PROFILE_H_
+
+#include <cstdint>
+
+#include "ember/keyboard/config.h"
+
+namespace ember {
+/**
+ * @brief Built-in switch profile, selected per key by
+ * KeySwitchConfig::switch_type.
+ * スイッチの種類ごとのストローク、カーブ、推奨デッドゾーンとラピッドトリガー設定。
+ * @note 23 bytes
+ */
+struct SwitchProfile {
+  // Full travel in 0.1mm. The curve knots are at i * travel / 8.
+  uint8_t travel;
+  uint8_t top_deadzone;
+  uint8_t bottom_deadzone;
+  uint8_t rappid_trigger_up_sensivity;
+  uint8_t rappid_trigger_down_sensivity;
+  KeySwitchCurve curve;
+} __attribute__((packed));
+
+/**
+ * @brief
+ * 0: Custom (4.0mm, the key config and curve are left as they are)
+ * 1: Standard 4.0mm
+ * 2: Short 3.5mm, strong magnet
+ * 3: Low profile 3.0mm, weak magnet
+ * 4: Linear response 4.0mm
+ */
+constexpr uint8_t kSwitchTypes = 5;
+
+/**
+ * @brief Get the profile of a switch type. Unknown types are Custom.
+ */
+const SwitchProfile& GetSwitchProfile(uint8_t switch_type);
+
+/**
+ * @brief Write the curve, deadzones and rapid trigger defaults of the switch
+ * type of a key. The actuation and release points are kept, clamped to the
+ * travel. Custom keeps everything.
+ */
+void ApplySwitchProfile(KeySwitchConfig& config, KeySwitchCurve& curve);
+}  // namespace ember
+
+#endif  // EMBER_KEYBOARD_SWITCH_PROFILE_H_
@@ -0,0 +1,71 @@
+#ifndef EMBER_KEYBOARD_USAGE_STATS_H_
+#define EMBER_KEYBOARD_USAGE_STATS_H_
+
+#include <cstdint>
+
+namespace ember {
+// "EB" + 02, stored in its own flash page apart from Config
+constexpr uint16_t kUsageStatsMagic = 0xEB02;
+constexpr uint16_t kUsageStatsVersion = 1;
+constexpr uint8_t kUsageBuckets = 8;
+
+/**
+ * @brief Usage statistics of a key. Buckets saturate at 65535.
+ * @note 36 bytes
+ */
+struct KeyUsage {
+  uint32_t actuations = 0;
+  // Press duration. Bucket i is shorter than 16ms << i, the last bucket is
+  // 1024ms or longer.
+  uint16_t dwell_histogram[kUsageBuckets] = {};
+  // Deepest travel of each press in 0.5mm buckets (3.5mm~ is the last one)
+  uint16_t depth_histogram[kUsageBuckets] = {};
+} __attribute__((packed));
+
+/**
+ * @brief UsageStats
+ * @note 1156 bytes
+ */
+struct UsageStats {
+  uint16_t magic = kUsageStatsMagic;
+  uint16_t version = kUsageStatsVersion;
+  KeyUsage keys[32];
+} __attribute__((packed));
+
+static_assert(sizeof(KeyUsage) == 36, "KeyUsage must be 36 bytes");
+static_assert(sizeof(UsageStats) % 2 == 0,
+              "UsageStats is programmed in half words");
+
+/**
+ * @brief Update UsageStats from the key states at the scan rate.
+ */
+class UsageRecorder {
+ public:
+  /**
+   * @brief Record a sample of a key.
+   * @param pressed the key is pressed.
+   * @param position position in 0.1mm.
+   * @param tick HAL_GetTick()
+   */
+  void Update(uint8_t index, bool pressed, uint8_t position, uint32_t tick);
+  UsageStats& GetStats() { return stats_; }
+  /**
+   * @brief Changed since the last MarkSaved().
+   */
+  bool IsDirty() const { return dirty_; }
+  void MarkSaved() { dirty_ = false; }
+  void Clear();
+
+ private:
+  static constexpr uint32_t kFirstDwellBucket = 16;
+  static constexpr uint8_t kDepthBucket = 5;
+
+  UsageStats stats_;
+  uint32_t pressed_ = 0;
+  uint32_t press_tick_[32] = {};
+  uint8_t max_position_[32] = {};
+  volatile bool dirty_ = false;
+};
+}  // namespace ember
+
+#endif  // EMBER_KEYBOARD_USAGE_STATS_H_
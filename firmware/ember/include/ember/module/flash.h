@@ -4,6 +4,7 @@
 #include <cstring>
 
 #include "ember/keyboard/config.h"
+#include "ember/keyboard/usage_stats.h"
 #include "main.h"
 
 namespace ember {
@@ -11,10 +12,46 @@ class Flash {
  public:
   static void SaveConfig(const ember::Config& config);
   static bool LoadConfig(ember::Config& config);
+  /**
+   * @brief Replace only the calibration data of the config stored in flash.
+   */
+  static void SaveCalibrationData(
+      const KeySwitchCalibrationData (&calibration_data)[32]);
   static Config GetDefaultConfig();
+  static void SaveUsageStats(const UsageStats& stats);
+  /**
+   * @brief Load the usage statistics.
+   * @return false if none were saved, stats is cleared.
+   */
+  static bool LoadUsageStats(UsageStats& stats);
 
  private:
+  /**
+   * @brief Upgrade a config read from flash to kConfigVersion.
+   * @return false if the stored config can not be migrated.
+   */
+  static bool MigrateConfig(Config& config);
+  static void MigrateLegacyConfig(Config& config);
+  /**
+   * @brief Build the curve of the logarithmic conversion used before
+   * KeySwitchCurve existed.
+   */
+  static KeySwitchCurve MakeLogCurve(
+      const KeySwitchCalibrationData& calibration_data);
+  static void SetDefaultSocdGroups(Config& config);
+  /**
+   * @brief Erase a page and program data to it.
+   */
+  static void Program(uint32_t address, const void* data, size_t size);
+
+  // The last two 2KB pages of the 128KB flash, kept out of FLASH by
+  // STM32F303CBTx_FLASH.ld
+  constexpr static uint32_t kPageSize = 0x800;
   constexpr static uint32_t kFlashStartAddress = 0x801F800;
+  constexpr static uint32_t kUsageStatsAddress = 0x801F000;
+  static_assert(sizeof(Config) <= kPageSize, "Config must fit in a page");
+  static_assert(sizeof(UsageStats) <= kPageSize,
+                "UsageStats must fit in a page");
 };
 }  // namespace ember
 
@@ -0,0 +1,27 @@
+#ifndef EMBER_UTILS_CYCLE_COUNTER_H_
+#define EMBER_UTILS_CYCLE_COUNTER_H_
+
+#include <cstdint>
+
+#include "main.h"
+
+namespace ember {
+/**
+ * @brief CPU cycle counter (DWT->CYCCNT) for timestamps finer than HAL_GetTick.
+ * @note Wraps every 2^32 cycles, compare timestamps by subtraction.
+ */
+class CycleCounter {
+ public:
+  static void Init() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  }
+  static uint32_t Now() { return DWT->CYCCNT; }
+  static uint32_t ToMicros(uint32_t cycles) {
+    return cycles / (SystemCoreClock / 1000000);
+  }
+};
+}  // namespace ember
+
+#endif  // EMBER_UTILS_CYCLE_COUNTER_H_
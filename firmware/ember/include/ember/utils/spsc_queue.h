@@ -0,0 +1,71 @@
+#ifndef EMBER_UTILS_SPSC_QUEUE_H_
+#define EMBER_UTILS_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ember {
+/**
+ * @brief Lock-free single producer single consumer ring buffer.
+ * @note Push() must be called from one context (e.g. the ADC interrupt) and
+ * Peek()/Pop() from one other context. No allocation, no interrupt masking.
+ */
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of 2");
+
+ public:
+  /**
+   * @brief Push an item (producer).
+   * @return false if the queue is full.
+   */
+  bool Push(const T& item) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == N) {
+      return false;
+    }
+    buffer_[head & (N - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+  /**
+   * @brief Read the oldest item without removing it (consumer).
+   * @return false if the queue is empty.
+   */
+  bool Peek(T& item) const {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail) {
+      return false;
+    }
+    item = buffer_[tail & (N - 1)];
+    return true;
+  }
+  /**
+   * @brief Remove the oldest item (consumer).
+   */
+  void Pop() {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) != tail) {
+      tail_.store(tail + 1, std::memory_order_release);
+    }
+  }
+  /**
+   * @brief Number of items. Exact only from the producer or the consumer.
+   */
+  size_t Size() const {
+    return head_.load(std::memory_order_acquire) -
+           tail_.load(std::memory_order_acquire);
+  }
+  bool Empty() const { return Size() == 0; }
+  static constexpr size_t Capacity() { return N; }
+
+ private:
+  // Free running indices, wrapped with N - 1 on access.
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  T buffer_[N];
+};
+}  // namespace ember
+
+#endif  // EMBER_UTILS_SPSC_QUEUE_H_
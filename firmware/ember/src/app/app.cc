@@ -1,11 +1,14 @@
 #include "ember/app/app.h"
 
 #include "SEGGER_RTT.h"
+#include "ember/app/usb_descriptors.h"
 #include "ember/commnication/configrator.h"
+#include "ember/commnication/telemetry.h"
 #include "ember/keyboard/config.h"
 #include "ember/keyboard/keyboard.h"
 #include "ember/module/cd4051b.h"
 #include "ember/module/flash.h"
+#include "ember/utils/cycle_counter.h"
 
 // Keyboard
 ember::Keyboard* keyboard;
@@ -54,6 +57,7 @@ void usb_bootloader_init() {
 
 void setup() {
   SEGGER_RTT_Init();
+  ember::CycleCounter::Init();
   // Load Config
   bool load_success = ember::Flash::LoadConfig(config);
   keyboard = new ember::Keyboard(config);
@@ -75,6 +79,7 @@ void setup() {
   HAL_ADCEx_MultiModeStart_DMA(&hadc3, reinterpret_cast<uint32_t*>(adc_val + 2),
                                1);
   // TinyUSB init
+  usb_set_hid_polling_interval(config.device_config.polling_interval);
 
   tusb_rhport_init_t dev_init = {
     .role = TUSB_ROLE_DEVICE,
@@ -88,11 +93,75 @@ void setup() {
   ember::Configurator::GetInstance()->SetKeyboard(keyboard);
   ember::Configurator::GetInstance()->SetConfig(&config);
   ember::Configurator::GetInstance()->Init();
+  ember::Telemetry::GetInstance()->SetKeyboard(keyboard);
 
   SEGGER_RTT_printf(0, "Ember startup.\n");
 }
 
-void loop() { tud_task(); }
+void loop() {
+  tud_task();
+  // Starts the reports while the endpoint is idle, the rest are sent from
+  // tud_hid_report_complete_cb.
+  keyboard->SendReport();
+  ember::Telemetry::GetInstance()->Task();
+  ember::Configurator::GetInstance()->Publish();
+  keyboard->Task();
+}
+
+// Invoked when the device is mounted or resumed. The host may have forgotten the keys
+// held, send them again.
+void tud_mount_cb(void) {
+  // The interfaces start in report protocol.
+  keyboard->SetBootProtocol(false);
+  keyboard->ResendReport();
+}
+void tud_resume_cb(void) { keyboard->ResendReport(); }
+
+// Invoked when the host selects the boot or report protocol (SET_PROTOCOL).
+// BIOS and KVMs select the boot protocol on the keyboard interface.
+void tud_hid_set_protocol_cb(uint8_t instance, uint8_t protocol) {
+  if (instance == HID_INSTANCE_KEYBOARD) {
+    keyboard->SetBootProtocol(protocol == HID_PROTOCOL_BOOT);
+  }
+}
+
+// Invoked when the host has read the report
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report,
+                                uint16_t len) {
+  (void)report;
+  (void)len;
+  if (instance == HID_INSTANCE_TELEMETRY) {
+    ember::Telemetry::GetInstance()->Task();
+    return;
+  }
+  keyboard->OnReportComplete(instance);
+}
+
+// Invoked when received GET_REPORT control request
+// Application must fill buffer report's content and return its length.
+// Return zero will cause the stack to STALL request
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id,
+                               hid_report_type_t report_type, uint8_t* buffer,
+                               uint16_t reqlen) {
+  (void)instance;
+  (void)report_id;
+  (void)report_type;
+  (void)buffer;
+  (void)reqlen;
+  return 0;
+}
+
+// Invoked when received SET_REPORT control request or
+// received data on OUT endpoint ( Report ID = 0, Type = 0 )
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id,
+                           hid_report_type_t report_type, uint8_t const* buffer,
+                           uint16_t bufsize) {
+  (void)report_id;
+  (void)report_type;
+  if (instance == HID_INSTANCE_TELEMETRY) {
+    ember::Telemetry::GetInstance()->OnOutputReport(buffer, bufsize);
+  }
+}
 
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim) {
   if (htim == &htim17) {
@@ -75,11 +75,69 @@ uint8_t const *tud_descriptor_device_cb(void) {
 uint8_t const desc_hid_report[] = {
     TUD_HID_REPORT_DESC_KEYBOARD()};
 
+// NKRO keyboard: a bit per usage 0x00-0xE7, modifiers included (29 bytes)
+uint8_t const desc_hid_nkro_report[] = {
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+    HID_USAGE(HID_USAGE_DESKTOP_KEYBOARD),
+    HID_COLLECTION(HID_COLLECTION_APPLICATION),
+      HID_USAGE_PAGE(HID_USAGE_PAGE_KEYBOARD),
+      HID_USAGE_MIN(0x00),
+      HID_USAGE_MAX(0xE7),
+      HID_LOGICAL_MIN(0),
+      HID_LOGICAL_MAX(1),
+      HID_REPORT_COUNT(0xE8),
+      HID_REPORT_SIZE(1),
+      HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+    HID_COLLECTION_END};
+
+// Telemetry: vendor defined 64 byte input (TelemetryFrame) and output
+// (commands) reports
+uint8_t const desc_hid_telemetry_report[] = {
+    TUD_HID_REPORT_DESC_GENERIC_INOUT(CFG_TUD_HID_EP_BUFSIZE)};
+
+// Media and system control keys: 16 bit consumer usage and system control
+// (power down, sleep, wake up) reports
+uint8_t const desc_hid_control_report[] = {
+    TUD_HID_REPORT_DESC_CONSUMER(
+        HID_REPORT_ID(REPORT_ID_CONSUMER_CONTROL)),
+    TUD_HID_REPORT_DESC_SYSTEM_CONTROL(
+        HID_REPORT_ID(REPORT_ID_SYSTEM_CONTROL))};
+
+// Gamepad: 6 axes driven by the travel of the keys (GamepadReport, 12 bytes)
+uint8_t const desc_hid_gamepad_report[] = {
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+    HID_USAGE(HID_USAGE_DESKTOP_GAMEPAD),
+    HID_COLLECTION(HID_COLLECTION_APPLICATION),
+      HID_REPORT_ID(REPORT_ID_GAMEPAD)
+      HID_USAGE(HID_USAGE_DESKTOP_X),
+      HID_USAGE(HID_USAGE_DESKTOP_Y),
+      HID_USAGE(HID_USAGE_DESKTOP_Z),
+      HID_USAGE(HID_USAGE_DESKTOP_RX),
+      HID_USAGE(HID_USAGE_DESKTOP_RY),
+      HID_USAGE(HID_USAGE_DESKTOP_RZ),
+      HID_LOGICAL_MIN_N(-32767, 2),
+      HID_LOGICAL_MAX_N(32767, 2),
+      HID_REPORT_COUNT(6),
+      HID_REPORT_SIZE(16),
+      HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+    HID_COLLECTION_END};
+
 // Invoked when received GET HID REPORT DESCRIPTOR
 // Application return pointer to descriptor
 // Descriptor contents must exist long enough for transfer to complete
 uint8_t const *tud_hid_descriptor_report_cb(uint8_t itf) {
-  (void)itf;
+  if (itf == HID_INSTANCE_NKRO) {
+    return desc_hid_nkro_report;
+  }
+  if (itf == HID_INSTANCE_TELEMETRY) {
+    return desc_hid_telemetry_report;
+  }
+  if (itf == HID_INSTANCE_CONTROL) {
+    return desc_hid_control_report;
+  }
+  if (itf == HID_INSTANCE_GAMEPAD) {
+    return desc_hid_gamepad_report;
+  }
   return desc_hid_report;
 }
 
@@ -87,17 +145,35 @@ uint8_t const *tud_hid_descriptor_report_cb(uint8_t itf) {
 // Configuration Descriptor
 //--------------------------------------------------------------------+
 
-enum { ITF_NUM_CDC = 0, ITF_NUM_CDC_DATA, ITF_NUM_HID, ITF_NUM_TOTAL };
+enum {
+  ITF_NUM_CDC = 0,
+  ITF_NUM_CDC_DATA,
+  ITF_NUM_HID,
+  ITF_NUM_HID_NKRO,
+  ITF_NUM_HID_TELEMETRY,
+  ITF_NUM_HID_CONTROL,
+  ITF_NUM_HID_GAMEPAD,
+  ITF_NUM_TOTAL
+};
 
 #define EPNUM_CDC_NOTIF 0x81
 #define EPNUM_CDC_OUT 0x02
 #define EPNUM_CDC_IN 0x82
+#define EPNUM_HID_CONTROL 0x83
+#define EPNUM_HID_NKRO 0x84
 #define EPNUM_HID 0x85
+#define EPNUM_HID_TELEMETRY 0x86
+#define EPNUM_HID_GAMEPAD 0x87
 
 #define CONFIG_TOTAL_LEN \
-  (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_HID_DESC_LEN)
+  (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + 5 * TUD_HID_DESC_LEN)
+// bInterval is the last byte of a HID endpoint descriptor
+#define HID_INTERVAL_OFFSET \
+  (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_HID_DESC_LEN - 1)
+#define HID_NKRO_INTERVAL_OFFSET (HID_INTERVAL_OFFSET + TUD_HID_DESC_LEN)
 
-uint8_t const desc_configuration[] = {
+// Not const, the polling interval is patched from the config at startup.
+uint8_t desc_configuration[] = {
     // Config number, interface count, string index, total length, attribute,
     // power in mA
     TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 100),
@@ -109,9 +185,36 @@ uint8_t const desc_configuration[] = {
 
     // Interface number, string index, protocol, report descriptor len, EP In
     // address, size & polling interval
-    TUD_HID_DESCRIPTOR(ITF_NUM_HID, 5, HID_ITF_PROTOCOL_NONE,
-                       sizeof(desc_hid_report), EPNUM_HID,
-                       CFG_TUD_HID_EP_BUFSIZE, 10)};
+    // Boot keyboard (subclass boot, protocol keyboard) so that BIOS and KVMs
+    // can use it. The 6KRO report is the boot report.
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID, 5, HID_ITF_PROTOCOL_KEYBOARD,
+                       sizeof(desc_hid_report), EPNUM_HID, 8, 1),
+    // 29 byte report
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID_NKRO, 6, HID_ITF_PROTOCOL_NONE,
+                       sizeof(desc_hid_nkro_report), EPNUM_HID_NKRO, 32, 1),
+    // Streams at the rate requested by the host, independent of
+    // polling_interval
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID_TELEMETRY, 7, HID_ITF_PROTOCOL_NONE,
+                       sizeof(desc_hid_telemetry_report), EPNUM_HID_TELEMETRY,
+                       CFG_TUD_HID_EP_BUFSIZE, 1),
+    // Media and system control keys, own endpoint so that they never wait
+    // for the keyboard reports. 3 byte reports.
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID_CONTROL, 8, HID_ITF_PROTOCOL_NONE,
+                       sizeof(desc_hid_control_report), EPNUM_HID_CONTROL, 8,
+                       1),
+    // Updated every scan, 13 byte report (report ID + GamepadReport)
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID_GAMEPAD, 9, HID_ITF_PROTOCOL_NONE,
+                       sizeof(desc_hid_gamepad_report), EPNUM_HID_GAMEPAD, 16,
+                       1)};
+
+void usb_set_hid_polling_interval(uint8_t interval) {
+  // 1ms is the shortest interval of a full speed interrupt endpoint
+  if (interval == 0) {
+    interval = 1;
+  }
+  desc_configuration[HID_INTERVAL_OFFSET] = interval;
+  desc_configuration[HID_NKRO_INTERVAL_OFFSET] = interval;
+}
 
 // Invoked when received GET CONFIGURATION DESCRIPTOR
 // Application return pointer to descriptor
@@ -133,6 +236,10 @@ char const *string_desc_arr[] = {
     "123456789012",              // 3: Serials, should use chip ID
     "TinyUSB CDC",               // 4: CDC Interface
     "TinyUSB MSC",               // 5: MSC Interface
+    "TinyUSB NKRO Keyboard",     // 6: NKRO Keyboard Interface
+    "TinyUSB Telemetry",         // 7: Telemetry Interface
+    "TinyUSB Media Keys",        // 8: Media and System Control Interface
+    "TinyUSB Gamepad",           // 9: Gamepad Interface
 };
 
 static uint16_t _desc_str[32];
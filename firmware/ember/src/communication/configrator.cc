@@ -69,35 +69,8 @@ void Configurator::ProcessCompleteMessage() {
     response[2] = address & 0xFF;
     response[3] = length;
 
-    if (0x0000 <= address && address < sizeof(config_->key_switch_configs) &&
-        address + length - 1 < sizeof(config_->key_switch_configs)) {
-      // Key Settings
-      response[0] = 0x00;
-      memcpy(response + 4,
-             reinterpret_cast<uint8_t*>(&config_->key_switch_configs) + address,
-             length);
-    }
-
-    if (0x1000 <= address &&
-        address < 0x1000 + sizeof(config_->key_switch_calibration_data) &&
-        address + length - 1 <
-            0x1000 + sizeof(config_->key_switch_calibration_data)) {
-      // Calibration Data
+    if (ReadRegion(address, length, response + 4)) {
       response[0] = 0x00;
-      memcpy(response + 4,
-             reinterpret_cast<uint8_t*>(&config_->key_switch_calibration_data) +
-                 (address - 0x1000),
-             length);
-    }
-
-    if (0x2000 <= address && address < 0x2000 + 32 &&
-        address + length - 1 < 0x2000 + 32) {
-      // Push Distance
-      response[0] = 0x00;
-      for (int i = 0; i < length; i++) {
-        response[4 + i] =
-            keyboard_->key_switches_[(address - 0x2000) + i]->GetLastPosition();
-      }
     }
 
     // Send Response
@@ -126,21 +99,72 @@ void Configurator::ProcessCompleteMessage() {
     uint8_t* data = decoded_buf + 4;
 
     // Key Settings
-    if (0x0000 <= address && address <= 0x0120 &&
-        address + length - 1 <= 0x0120) {
+    if (0x0000 <= address && address < sizeof(config_->key_switch_configs) &&
+        address + length - 1 < sizeof(config_->key_switch_configs)) {
       memcpy(reinterpret_cast<uint8_t*>(&config_->key_switch_configs) + address,
              data, length);
       response[0] = 0x00;
     }
 
+    // Curves
+    if (0x1100 <= address &&
+        address < 0x1100 + sizeof(config_->key_switch_curves) &&
+        address + length - 1 < 0x1100 + sizeof(config_->key_switch_curves)) {
+      memcpy(reinterpret_cast<uint8_t*>(&config_->key_switch_curves) +
+                 (address - 0x1100),
+             data, length);
+      response[0] = 0x00;
+    }
+
+    // Device Config
+    if (0x1800 <= address &&
+        address < 0x1800 + sizeof(config_->device_config) &&
+        address + length - 1 < 0x1800 + sizeof(config_->device_config)) {
+      memcpy(reinterpret_cast<uint8_t*>(&config_->device_config) +
+                 (address - 0x1800),
+             data, length);
+      response[0] = 0x00;
+    }
+
+    // SOCD Groups
+    if (0x1900 <= address &&
+        address < 0x1900 + sizeof(config_->socd_groups) &&
+        address + length - 1 < 0x1900 + sizeof(config_->socd_groups)) {
+      memcpy(reinterpret_cast<uint8_t*>(&config_->socd_groups) +
+                 (address - 0x1900),
+             data, length);
+      response[0] = 0x00;
+    }
+
+    // Dynamic Keystrokes
+    if (0x1A00 <= address &&
+        address < 0x1A00 + sizeof(config_->dynamic_keystrokes) &&
+        address + length - 1 < 0x1A00 + sizeof(config_->dynamic_keystrokes)) {
+      memcpy(reinterpret_cast<uint8_t*>(&config_->dynamic_keystrokes) +
+                 (address - 0x1A00),
+             data, length);
+      response[0] = 0x00;
+    }
+
+    // Gamepad Axes
+    if (0x1B00 <= address &&
+        address < 0x1B00 + sizeof(config_->gamepad_axes) &&
+        address + length - 1 < 0x1B00 + sizeof(config_->gamepad_axes)) {
+      memcpy(reinterpret_cast<uint8_t*>(&config_->gamepad_axes) +
+                 (address - 0x1B00),
+             data, length);
+      response[0] = 0x00;
+    }
+
     // Device Control
-    if (0x3000 <= address && address <= 0x3004 &&
-        address + length - 1 <= 0x3004) {
+    if (0x3000 <= address && address <= 0x3009 &&
+        address + length - 1 <= 0x3009) {
       for (int i = 0; i < length; i++) {
         switch (address + i) {
           case 0x3000:
             // Save Config
             Flash::SaveConfig(*config_);
+            keyboard_->MarkCalibrationSaved();
             response[0] = 0x00;
             break;
           case 0x3001:
@@ -162,13 +186,52 @@ void Configurator::ProcessCompleteMessage() {
             break;
           case 0x3003:
             // Reset MCU
+            keyboard_->SaveUsageStats();
             HAL_NVIC_SystemReset();
             break;
           case 0x3004:
             // Enter DFU Mode
+            keyboard_->SaveUsageStats();
             switchToBootloader = 0x11;
             NVIC_SystemReset();
             break;
+          case 0x3005:
+            // Clear key statistics
+            keyboard_->ClearStats();
+            response[0] = 0x00;
+            break;
+          case 0x3006:
+            // Deadzone suggestion
+            if (data[i] == 0x00) {
+              // Stop measuring and apply the suggested deadzones
+              keyboard_->StopNoiseMeasurement();
+            } else {
+              keyboard_->StartNoiseMeasurement();
+            }
+            response[0] = 0x00;
+            break;
+          case 0x3007:
+            // Curve capture (0 = stop, key index + 1 = start)
+            if (data[i] == 0x00) {
+              keyboard_->StopCurveCapture();
+            } else {
+              keyboard_->StartCurveCapture(data[i] - 1);
+            }
+            response[0] = 0x00;
+            break;
+          case 0x3008:
+            // Clear sensor faults and lift the quarantine
+            keyboard_->ClearFaults();
+            response[0] = 0x00;
+            break;
+          case 0x3009:
+            // Usage statistics (0 = clear, 1 = save now)
+            if (data[i] == 0x00) {
+              keyboard_->ClearUsageStats();
+            }
+            keyboard_->SaveUsageStats();
+            response[0] = 0x00;
+            break;
         }
       }
     }
@@ -180,7 +243,357 @@ void Configurator::ProcessCompleteMessage() {
     encoded_buf[encoded_length] = 0x00;
     tud_cdc_write(encoded_buf, encoded_length + 1);
     tud_cdc_write_flush();
+  } else if (func_code == 2) {
+    // Subscribe (interval, stride, key mask)
+    uint8_t response[4];
+    response[0] = 0x01;
+    response[1] = address >> 8;
+    response[2] = address & 0xFF;
+    response[3] = length;
+    if (length == 6 && decoded_length == 4 + 6) {
+      uint8_t* data = decoded_buf + 4;
+      uint32_t key_mask = data[2] | data[3] << 8 | data[4] << 16 |
+                          static_cast<uint32_t>(data[5]) << 24;
+      if (Subscribe(address, data[0], data[1], key_mask)) {
+        response[0] = 0x00;
+      }
+    }
+
+    // Send Response
+    uint32_t encoded_length = COBS::getEncodedBufferSize(4);
+    uint8_t encoded_buf[256];
+    COBS::encode(response, 4, encoded_buf);
+    encoded_buf[encoded_length] = 0x00;
+    tud_cdc_write(encoded_buf, encoded_length + 1);
+    tud_cdc_write_flush();
+  }
+}
+
+void Configurator::Publish() {
+  if (!tud_cdc_connected()) {
+    // The host closed the port. Drop the subscriptions so that the next
+    // session starts without stale pushes.
+    for (auto& subscription : subscriptions_) {
+      subscription.interval = 0;
+    }
+    return;
+  }
+
+  uint32_t tick = HAL_GetTick();
+  for (auto& subscription : subscriptions_) {
+    if (subscription.interval == 0 ||
+        tick - subscription.last_tick < subscription.interval) {
+      continue;
+    }
+
+    // Status, address and length, then up to 255 bytes of payload
+    uint8_t frame[4 + 255];
+    uint8_t length = kPushHeaderSize;
+    for (uint8_t i = 0; i < 32; i++) {
+      if (!(subscription.key_mask >> i & 1)) {
+        continue;
+      }
+      ReadRegion(subscription.address + i * subscription.stride,
+                 subscription.stride, frame + 4 + length);
+      length += subscription.stride;
+    }
+    frame[0] = 0x02;
+    frame[1] = subscription.address >> 8;
+    frame[2] = subscription.address & 0xFF;
+    frame[3] = length;
+    memcpy(frame + 4, &tick, 4);
+    memcpy(frame + 8, &subscription.key_mask, 4);
+
+    uint32_t encoded_length = COBS::getEncodedBufferSize(4 + length);
+    // Wait until the whole frame fits so that a slow host gets fewer frames
+    // instead of broken ones.
+    if (tud_cdc_write_available() < encoded_length + 1) {
+      return;
+    }
+    // COBS adds a byte per 254 bytes and the delimiter follows.
+    uint8_t encoded_buf[sizeof(frame) + sizeof(frame) / 254 + 2];
+    COBS::encode(frame, 4 + length, encoded_buf);
+    encoded_buf[encoded_length] = 0x00;
+    tud_cdc_write(encoded_buf, encoded_length + 1);
+    tud_cdc_write_flush();
+    subscription.last_tick = tick;
+  }
+}
+
+bool Configurator::Subscribe(uint16_t address, uint8_t interval,
+                             uint8_t stride, uint32_t key_mask) {
+  Subscription* slot = nullptr;
+  for (auto& subscription : subscriptions_) {
+    if (subscription.interval != 0 && subscription.address == address) {
+      slot = &subscription;
+      break;
+    }
+  }
+  if (interval == 0) {
+    // Unsubscribe
+    if (slot != nullptr) {
+      slot->interval = 0;
+    }
+    return true;
+  }
+
+  if (stride == 0 || key_mask == 0 ||
+      kPushHeaderSize + stride * __builtin_popcount(key_mask) > 255) {
+    return false;
+  }
+  uint8_t value[255];
+  for (uint8_t i = 0; i < 32; i++) {
+    if ((key_mask >> i & 1) &&
+        !ReadRegion(address + i * stride, stride, value)) {
+      return false;
+    }
+  }
+
+  if (slot == nullptr) {
+    for (auto& subscription : subscriptions_) {
+      if (subscription.interval == 0) {
+        slot = &subscription;
+        break;
+      }
+    }
+    if (slot == nullptr) {
+      return false;
+    }
+  }
+  slot->address = address;
+  slot->stride = stride;
+  slot->interval = interval;
+  slot->key_mask = key_mask;
+  slot->last_tick = HAL_GetTick() - interval;
+  return true;
+}
+
+bool Configurator::ReadRegion(uint16_t address, uint8_t length,
+                              uint8_t* dst) {
+  bool found = false;
+  if (0x0000 <= address && address < sizeof(config_->key_switch_configs) &&
+      address + length - 1 < sizeof(config_->key_switch_configs)) {
+    // Key Settings
+    found = true;
+    memcpy(dst,
+           reinterpret_cast<uint8_t*>(&config_->key_switch_configs) + address,
+           length);
+  }
+
+  if (0x1000 <= address &&
+      address < 0x1000 + sizeof(config_->key_switch_calibration_data) &&
+      address + length - 1 <
+          0x1000 + sizeof(config_->key_switch_calibration_data)) {
+    // Calibration Data
+    found = true;
+    memcpy(dst,
+           reinterpret_cast<uint8_t*>(&config_->key_switch_calibration_data) +
+               (address - 0x1000),
+           length);
+  }
+
+  if (0x1100 <= address &&
+      address < 0x1100 + sizeof(config_->key_switch_curves) &&
+      address + length - 1 < 0x1100 + sizeof(config_->key_switch_curves)) {
+    // Curves
+    found = true;
+    memcpy(dst,
+           reinterpret_cast<uint8_t*>(&config_->key_switch_curves) +
+               (address - 0x1100),
+           length);
+  }
+
+  if (0x1800 <= address &&
+      address < 0x1800 + sizeof(config_->device_config) &&
+      address + length - 1 < 0x1800 + sizeof(config_->device_config)) {
+    // Device Config
+    found = true;
+    memcpy(dst,
+           reinterpret_cast<uint8_t*>(&config_->device_config) +
+               (address - 0x1800),
+           length);
+  }
+
+  if (0x1900 <= address &&
+      address < 0x1900 + sizeof(config_->socd_groups) &&
+      address + length - 1 < 0x1900 + sizeof(config_->socd_groups)) {
+    // SOCD Groups
+    found = true;
+    memcpy(dst,
+           reinterpret_cast<uint8_t*>(&config_->socd_groups) +
+               (address - 0x1900),
+           length);
+  }
+
+  if (0x1A00 <= address &&
+      address < 0x1A00 + sizeof(config_->dynamic_keystrokes) &&
+      address + length - 1 < 0x1A00 + sizeof(config_->dynamic_keystrokes)) {
+    // Dynamic Keystrokes
+    found = true;
+    memcpy(dst,
+           reinterpret_cast<uint8_t*>(&config_->dynamic_keystrokes) +
+               (address - 0x1A00),
+           length);
+  }
+
+  if (0x1B00 <= address &&
+      address < 0x1B00 + sizeof(config_->gamepad_axes) &&
+      address + length - 1 < 0x1B00 + sizeof(config_->gamepad_axes)) {
+    // Gamepad Axes
+    found = true;
+    memcpy(dst,
+           reinterpret_cast<uint8_t*>(&config_->gamepad_axes) +
+               (address - 0x1B00),
+           length);
+  }
+
+  if (0x2000 <= address && address < 0x2000 + 32 &&
+      address + length - 1 < 0x2000 + 32) {
+    // Push Distance
+    found = true;
+    for (int i = 0; i < length; i++) {
+      dst[i] =
+          keyboard_->key_switches_[(address - 0x2000) + i]->GetLastPosition();
+    }
+  }
+
+  // Chatter Count
+  if (ReadKeyStats(address, length, 0x4000,
+                   [](const KeySwitchStats& s) { return s.chatter_count; },
+                   dst)) {
+    found = true;
+  }
+
+  if (0x4040 <= address && address < 0x4040 + 32 * 2 &&
+      address + length - 1 < 0x4040 + 32 * 2) {
+    // Noise (top, bottom)
+    found = true;
+    for (int i = 0; i < length; i++) {
+      uint16_t offset = address - 0x4040 + i;
+      KeySwitchStats& stats = keyboard_->key_switches_[offset / 2]->GetStats();
+      dst[i] =
+          (offset % 2 == 0) ? stats.top_noise : stats.bottom_noise;
+    }
+  }
+
+  if (0x2100 <= address && address < 0x2100 + 32 * 2 &&
+      address + length - 1 < 0x2100 + 32 * 2) {
+    // Raw ADC Value
+    found = true;
+    for (int i = 0; i < length; i++) {
+      uint16_t offset = address - 0x2100 + i;
+      uint16_t value = keyboard_->GetRawValue(offset / 2);
+      dst[i] = (offset % 2 == 0) ? value & 0xFF : value >> 8;
+    }
+  }
+
+  if (0x2200 <= address && address < 0x2200 + sizeof(GamepadReport) &&
+      address + length - 1 < 0x2200 + sizeof(GamepadReport)) {
+    // Gamepad Axis Values
+    found = true;
+    GamepadReport report = keyboard_->GetGamepadReport();
+    memcpy(dst, reinterpret_cast<uint8_t*>(&report) + (address - 0x2200),
+           length);
+  }
+
+  // Predicted Edges
+  if (ReadKeyStats(address, length, 0x4080,
+                   [](const KeySwitchStats& s) { return s.predicted_edges; },
+                   dst)) {
+    found = true;
+  }
+
+  // Confirmed Edges
+  if (ReadKeyStats(address, length, 0x40C0,
+                   [](const KeySwitchStats& s) { return s.confirmed_edges; },
+                   dst)) {
+    found = true;
+  }
+
+  if (0x4100 <= address && address + length - 1 < 0x4102) {
+    // Curve Capture Count
+    found = true;
+    uint16_t count = keyboard_->GetCaptureCount();
+    for (int i = 0; i < length; i++) {
+      uint16_t offset = address - 0x4100 + i;
+      dst[i] = (offset % 2 == 0) ? count & 0xFF : count >> 8;
+    }
+  }
+
+  if (0x4110 <= address && address < 0x4110 + sizeof(KeyEventStats) &&
+      address + length - 1 < 0x4110 + sizeof(KeyEventStats)) {
+    // Key Event Queue Counters
+    found = true;
+    KeyEventStats stats = keyboard_->GetKeyEventStats();
+    memcpy(dst,
+           reinterpret_cast<uint8_t*>(&stats) + (address - 0x4110), length);
+  }
+
+  if (0x4120 <= address && address < 0x4120 + sizeof(ReportLatencyStats) &&
+      address + length - 1 < 0x4120 + sizeof(ReportLatencyStats)) {
+    // Report Latency
+    found = true;
+    ReportLatencyStats stats = keyboard_->GetReportLatencyStats();
+    memcpy(dst,
+           reinterpret_cast<uint8_t*>(&stats) + (address - 0x4120), length);
+  }
+
+  if (0x4130 <= address && address < 0x4130 + sizeof(HidTxStats) &&
+      address + length - 1 < 0x4130 + sizeof(HidTxStats)) {
+    // HID Transmission Counters
+    found = true;
+    HidTxStats stats = keyboard_->GetHidTxStats();
+    memcpy(dst,
+           reinterpret_cast<uint8_t*>(&stats) + (address - 0x4130), length);
+  }
+
+  if (0x4140 <= address && address < 0x4140 + 32 &&
+      address + length - 1 < 0x4140 + 32) {
+    // Sensor Fault Flags
+    found = true;
+    for (int i = 0; i < length; i++) {
+      dst[i] = keyboard_->GetFaultFlags(address - 0x4140 + i);
+    }
+  }
+
+  if (0x5000 <= address && address < 0x5000 + Keyboard::kCaptureSize * 2 &&
+      address + length - 1 < 0x5000 + Keyboard::kCaptureSize * 2) {
+    // Curve Capture Samples
+    found = true;
+    for (int i = 0; i < length; i++) {
+      uint16_t offset = address - 0x5000 + i;
+      uint16_t value = keyboard_->GetCaptureSample(offset / 2);
+      dst[i] = (offset % 2 == 0) ? value & 0xFF : value >> 8;
+    }
+  }
+
+  if (0x6000 <= address && address < 0x6000 + sizeof(UsageStats::keys) &&
+      address + length - 1 < 0x6000 + sizeof(UsageStats::keys)) {
+    // Usage Statistics
+    found = true;
+    memcpy(dst,
+           reinterpret_cast<const uint8_t*>(
+               keyboard_->GetUsageStats().keys) +
+               (address - 0x6000),
+           length);
+  }
+  return found;
+}
+
+bool Configurator::ReadKeyStats(uint16_t address, uint8_t length,
+                                uint16_t base,
+                                uint16_t (*getter)(const KeySwitchStats&),
+                                uint8_t* dst) {
+  if (address < base || base + 32 * 2 <= address ||
+      base + 32 * 2 <= address + length - 1) {
+    return false;
+  }
+  for (int i = 0; i < length; i++) {
+    uint16_t offset = address - base + i;
+    uint16_t value = getter(keyboard_->key_switches_[offset / 2]->GetStats());
+    dst[i] = (offset % 2 == 0) ? value & 0xFF : value >> 8;
   }
+  return true;
 }
 }  // namespace ember
 
@@ -0,0 +1,111 @@
+#include "ember/commnication/telemetry.h"
+
+#include "ember/app/usb_descriptors.h"
+#include "ember/utils/cycle_counter.h"
+#include "tusb.h"
+
+namespace ember {
+void Telemetry::Task() {
+  uint32_t now_us = Micros();
+  if (!streaming_ || keyboard_ == nullptr) {
+    return;
+  }
+  if (raw_) {
+    RawTask(now_us);
+    return;
+  }
+  if (!tud_hid_n_ready(HID_INSTANCE_TELEMETRY)) {
+    return;
+  }
+  uint32_t tick = HAL_GetTick();
+  if (tick - last_frame_tick_ < interval_ ||
+      keyboard_->GetScanCount() == last_scan_) {
+    return;
+  }
+  TelemetryFrame frame;
+  uint32_t scan_cycles;
+  // Take all keys from the same scan.
+  __disable_irq();
+  frame.scan = keyboard_->GetScanCount();
+  scan_cycles = keyboard_->GetScanTimestamp();
+  frame.pressed = keyboard_->GetPressed();
+  for (int i = 0; i < 32; i++) {
+    frame.travel[i] = keyboard_->key_switches_[i]->GetLastPosition();
+  }
+  __enable_irq();
+  frame.timestamp_us =
+      now_us - CycleCounter::ToMicros(CycleCounter::Now() - scan_cycles);
+  if (tud_hid_n_report(HID_INSTANCE_TELEMETRY, 0, &frame, sizeof(frame))) {
+    last_frame_tick_ = tick;
+    last_scan_ = frame.scan;
+  }
+}
+
+void Telemetry::OnOutputReport(const uint8_t* buffer, uint16_t size) {
+  if (size < 1) {
+    return;
+  }
+  switch (buffer[0]) {
+    case kCommandStop:
+      streaming_ = false;
+      break;
+    case kCommandStart:
+      interval_ = size >= 2 && buffer[1] != 0 ? buffer[1] : 1;
+      raw_ = false;
+      streaming_ = true;
+      break;
+    case kCommandStartRaw:
+      encoder_.Reset();
+      raw_ = true;
+      streaming_ = true;
+      break;
+    default:
+      break;
+  }
+}
+
+void Telemetry::RawTask(uint32_t now_us) {
+  if (keyboard_->GetScanCount() != last_scan_) {
+    uint16_t values[32];
+    uint32_t scan;
+    uint32_t scan_cycles;
+    __disable_irq();
+    scan = keyboard_->GetScanCount();
+    scan_cycles = keyboard_->GetScanTimestamp();
+    for (int i = 0; i < 32; i++) {
+      values[i] = keyboard_->GetRawValue(i);
+    }
+    __enable_irq();
+    uint32_t timestamp_us =
+        now_us - CycleCounter::ToMicros(CycleCounter::Now() - scan_cycles);
+    if (!encoder_.Append(scan, timestamp_us, values) &&
+        tud_hid_n_ready(HID_INSTANCE_TELEMETRY)) {
+      SendRawFrame();
+      encoder_.Append(scan, timestamp_us, values);
+    }
+    // A scan that did not fit while the previous frame was in flight is
+    // skipped, the gap shows in the scan numbers.
+    last_scan_ = scan;
+  }
+  if (!encoder_.IsEmpty() && tud_hid_n_ready(HID_INSTANCE_TELEMETRY)) {
+    SendRawFrame();
+  }
+}
+
+void Telemetry::SendRawFrame() {
+  TelemetryRawFrame frame = encoder_.Finish();
+  if (!tud_hid_n_report(HID_INSTANCE_TELEMETRY, 0, &frame, sizeof(frame))) {
+    // The host misses the deltas of the frame
+    encoder_.Reset();
+  }
+}
+
+uint32_t Telemetry::Micros() {
+  uint32_t cycles_per_us = SystemCoreClock / 1000000;
+  uint32_t elapsed = (CycleCounter::Now() - micros_cycles_) / cycles_per_us;
+  // Keep the remainder for the next call.
+  micros_cycles_ += elapsed * cycles_per_us;
+  micros_ += elapsed;
+  return micros_;
+}
+}  // namespace ember
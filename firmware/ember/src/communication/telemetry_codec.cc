@@ -0,0 +1,228 @@
+#include "ember/commnication/telemetry_codec.h"
+
+namespace ember {
+namespace {
+uint8_t VarintSize(uint32_t value) {
+  uint8_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+uint8_t WriteVarint(uint8_t* dst, uint32_t value) {
+  uint8_t size = 0;
+  while (value >= 0x80) {
+    dst[size++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  dst[size++] = value;
+  return size;
+}
+
+// Small differences of either sign become small unsigned values:
+// 0, -1, 1, -2, 2... -> 0, 1, 2, 3, 4...
+uint32_t ZigZag(int32_t value) {
+  return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+int32_t UnZigZag(uint32_t value) {
+  return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+}  // namespace
+
+void TelemetryEncoder::Reset() {
+  uint8_t sequence = sequence_;
+  *this = TelemetryEncoder();
+  sequence_ = sequence;
+}
+
+bool TelemetryEncoder::Append(uint32_t scan, uint32_t timestamp_us,
+                              const uint16_t* values) {
+  bool empty = IsEmpty();
+  uint32_t gap = empty ? 0 : scan - last_scan_;
+  if (gap > kMaxScanGap) {
+    return false;
+  }
+
+  bool keyframe = pending_keyframes_ > 0 ||
+                  records_since_keyframe_ >= kKeyframeInterval;
+  uint32_t keyframe_mask = !keyframe ? 0 : next_half_ ? 0xFFFF0000 : 0x0000FFFF;
+
+  // Choose the keys, the keyframe half first so that it is never cut short.
+  // A record that does not fit even an empty frame lists the changed keys it
+  // left out, which takes 4 more bytes.
+  uint8_t space = sizeof(frame_.records) - frame_.length;
+  uint16_t size;
+  uint32_t bitmap;
+  uint32_t skipped;
+  uint32_t encoded[32];
+  for (uint8_t header = 5;; header = 9) {
+    if (header > space) {
+      return false;
+    }
+    size = header;
+    bitmap = 0;
+    skipped = 0;
+    for (int pass = 0; pass < 2; pass++) {
+      for (uint8_t i = 0; i < 32; i++) {
+        bool absolute = keyframe_mask >> i & 1;
+        if (absolute != (pass == 0)) {
+          continue;
+        }
+        if (!absolute && values[i] == previous_[i]) {
+          continue;
+        }
+        uint32_t value =
+            absolute ? values[i] : ZigZag(values[i] - previous_[i]);
+        uint8_t value_size = VarintSize(value);
+        if (size + value_size > space) {
+          if (!empty) {
+            return false;
+          }
+          // The next record carries the change
+          skipped |= 1UL << i;
+          continue;
+        }
+        encoded[i] = value;
+        bitmap |= 1UL << i;
+        size += value_size;
+      }
+    }
+    if (skipped == 0 || header == 9) {
+      break;
+    }
+  }
+  bool keyframe_complete = keyframe && !(skipped & keyframe_mask);
+
+  if (empty) {
+    frame_.scan = scan;
+    frame_.timestamp_us = timestamp_us;
+  }
+  uint8_t* dst = frame_.records + frame_.length;
+  *dst++ = (keyframe ? 0x01 | next_half_ << 1 : 0x00) | gap << 2 |
+           (skipped != 0 ? 0x80 : 0x00);
+  for (int i = 0; i < 4; i++) {
+    *dst++ = bitmap >> (i * 8);
+  }
+  if (skipped != 0) {
+    for (int i = 0; i < 4; i++) {
+      *dst++ = skipped >> (i * 8);
+    }
+  }
+  for (uint8_t i = 0; i < 32; i++) {
+    if (bitmap >> i & 1) {
+      dst += WriteVarint(dst, encoded[i]);
+      previous_[i] = values[i];
+    }
+  }
+  frame_.length += size;
+  frame_.record_count++;
+  last_scan_ = scan;
+
+  if (keyframe_complete) {
+    next_half_ ^= 1;
+    records_since_keyframe_ = 0;
+    if (pending_keyframes_ > 0) {
+      pending_keyframes_--;
+    }
+  } else if (records_since_keyframe_ < kKeyframeInterval) {
+    records_since_keyframe_++;
+  }
+  return true;
+}
+
+TelemetryRawFrame TelemetryEncoder::Finish() {
+  TelemetryRawFrame frame = frame_;
+  frame.sequence = sequence_++;
+  frame_ = TelemetryRawFrame();
+  return frame;
+}
+
+int TelemetryDecoder::Decode(const uint8_t* data, uint16_t size,
+                             TelemetrySample* samples) {
+  constexpr uint16_t kHeaderSize = sizeof(TelemetryRawFrame) -
+                                   sizeof(TelemetryRawFrame::records);
+  if (size < kHeaderSize || data[0] != kTelemetryRawFrame) {
+    known_ = 0;
+    return -1;
+  }
+  uint8_t count = data[1];
+  uint16_t end = kHeaderSize + data[2];
+  if (count > kMaxRecords || end > size || end > sizeof(TelemetryRawFrame)) {
+    known_ = 0;
+    return -1;
+  }
+  // A lost frame took deltas with it, the values are stale until keyframes.
+  if (has_sequence_ && data[3] != next_sequence_) {
+    known_ = 0;
+  }
+  next_sequence_ = data[3] + 1;
+  has_sequence_ = true;
+  uint32_t scan = data[4] | data[5] << 8 | data[6] << 16 |
+                  static_cast<uint32_t>(data[7]) << 24;
+
+  uint16_t pos = kHeaderSize;
+  for (uint8_t r = 0; r < count; r++) {
+    if (pos + 5 > end) {
+      known_ = 0;
+      return -1;
+    }
+    uint8_t flags = data[pos];
+    uint32_t bitmap = data[pos + 1] | data[pos + 2] << 8 |
+                      data[pos + 3] << 16 |
+                      static_cast<uint32_t>(data[pos + 4]) << 24;
+    pos += 5;
+    uint32_t skipped = 0;
+    if (flags & 0x80) {
+      if (pos + 4 > end) {
+        known_ = 0;
+        return -1;
+      }
+      skipped = data[pos] | data[pos + 1] << 8 | data[pos + 2] << 16 |
+                static_cast<uint32_t>(data[pos + 3]) << 24;
+      pos += 4;
+    }
+    uint32_t keyframe_mask =
+        !(flags & 0x01) ? 0 : (flags & 0x02) ? 0xFFFF0000 : 0x0000FFFF;
+    scan += flags >> 2 & 0x1F;
+
+    for (uint8_t i = 0; i < 32; i++) {
+      if (!(bitmap >> i & 1)) {
+        continue;
+      }
+      uint32_t value = 0;
+      for (uint8_t shift = 0;; shift += 7) {
+        if (pos >= end || shift > 28) {
+          known_ = 0;
+          return -1;
+        }
+        uint8_t byte = data[pos++];
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+          break;
+        }
+      }
+      if (keyframe_mask >> i & 1) {
+        values_[i] = value;
+        known_ |= 1UL << i;
+      } else {
+        values_[i] += UnZigZag(value);
+      }
+    }
+
+    samples[r].scan = scan;
+    // The skipped keys hold the value of an older scan
+    samples[r].known = known_ & ~skipped;
+    for (uint8_t i = 0; i < 32; i++) {
+      samples[r].values[i] = values_[i];
+    }
+  }
+  if (pos != end) {
+    known_ = 0;
+    return -1;
+  }
+  return count;
+}
+}  // namespace ember
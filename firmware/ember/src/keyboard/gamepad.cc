@@ -0,0 +1,82 @@
+#include "ember/keyboard/gamepad.h"
+
+namespace ember {
+bool Gamepad::Update(const GamepadAxisConfig (&axes)[kGamepadAxes],
+                     const uint16_t (&travels)[32]) {
+  bool changed = false;
+  for (int a = 0; a < kGamepadAxes; a++) {
+    const GamepadAxisConfig& axis = axes[a];
+    int32_t positive = KeyValue(axis, axis.positive_key, travels);
+    int32_t value;
+    if (axis.negative_key != 0) {
+      // Both keys pressed cancel each other out.
+      int32_t negative = KeyValue(axis, axis.negative_key, travels);
+      value = (positive - negative) / 2;
+    } else if (axis.positive_key != 0) {
+      // Trigger: rest is the minimum
+      value = positive - kAxisMax;
+      if (value > kAxisMax) {
+        value = kAxisMax;
+      }
+    } else {
+      value = 0;
+    }
+    if (axis.flags & 0x01) {
+      value = -value;
+    }
+    if (report_.axes[a] != value) {
+      report_.axes[a] = value;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+uint32_t Gamepad::GetMappedKeys(
+    const GamepadAxisConfig (&axes)[kGamepadAxes]) {
+  uint32_t keys = 0;
+  for (int a = 0; a < kGamepadAxes; a++) {
+    uint8_t positive = axes[a].positive_key;
+    uint8_t negative = axes[a].negative_key;
+    if (positive != 0 && positive <= 32) {
+      keys |= 1UL << (positive - 1);
+    }
+    if (negative != 0 && negative <= 32) {
+      keys |= 1UL << (negative - 1);
+    }
+  }
+  return keys;
+}
+
+uint16_t Gamepad::KeyValue(const GamepadAxisConfig& axis, uint8_t key,
+                           const uint16_t (&travels)[32]) {
+  if (key == 0 || 32 < key) {
+    return 0;
+  }
+  return Shape(axis, travels[key - 1]);
+}
+
+uint16_t Gamepad::Shape(const GamepadAxisConfig& axis, uint16_t travel) {
+  uint32_t inner = axis.inner_deadzone * kCurveScale / 256;
+  uint32_t outer = kCurveScale - axis.outer_deadzone * kCurveScale / 256;
+  if (travel <= inner) {
+    return axis.curve[0] * 257;
+  }
+  if (travel >= outer) {
+    // Overlapping deadzones make an on/off axis.
+    return axis.curve[kGamepadCurveKnots - 1] * 257;
+  }
+  // Position between the deadzones, 0~kCurveScale
+  uint32_t x = (travel - inner) * kCurveScale / (outer - inner);
+  // Knot i is at i * kCurveScale / (kGamepadCurveKnots - 1).
+  uint32_t scaled = x * (kGamepadCurveKnots - 1);
+  uint8_t i = scaled / kCurveScale;
+  if (i >= kGamepadCurveKnots - 1) {
+    return axis.curve[kGamepadCurveKnots - 1] * 257;
+  }
+  int32_t fraction = scaled - i * kCurveScale;
+  int32_t rise = axis.curve[i + 1] - axis.curve[i];
+  // 1/255 units to kCurveScale: * 257, and 257 / kCurveScale = 1 / 255.
+  return axis.curve[i] * 257 + rise * fraction / 255;
+}
+}  // namespace ember
@@ -1,61 +1,354 @@
 #include "ember/keyboard/keyboard.h"
 
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "ember/app/usb_descriptors.h"
+#include "ember/module/flash.h"
+#include "ember/utils/cycle_counter.h"
+
 namespace ember {
 Keyboard::Keyboard(Config& config) : config_(config) {
   for (int i = 0; i < 32; i++) {
-    switch (config_.key_switch_configs[i].key_type) {
-      case 0:
-        key_switches_[i] =
-            new ThresholdKey(config_.key_switch_configs[i],
-                             config_.key_switch_calibration_data[i]);
-        break;
-      case 1:
-        key_switches_[i] =
-            new RapidTriggerKey(config_.key_switch_configs[i],
-                                config_.key_switch_calibration_data[i]);
-        break;
-      default:
-        key_switches_[i] =
-            new ThresholdKey(config_.key_switch_configs[i],
-                             config_.key_switch_calibration_data[i]);
-        break;
+    key_switches_[i] = nullptr;
+    CreateKeySwitch(i);
+    // The stored config already has the profile applied.
+    switch_types_[i] = config_.key_switch_configs[i].switch_type;
+  }
+  MarkCalibrationSaved();
+  Flash::LoadUsageStats(usage_.GetStats());
+  last_usage_save_tick_ = HAL_GetTick();
+}
+
+void Keyboard::CreateKeySwitch(uint8_t index) {
+  if (key_switches_[index] != nullptr) {
+    key_switches_[index]->~KeySwitchBase();
+  }
+  KeySwitchConfig& key_config = config_.key_switch_configs[index];
+  KeySwitchCalibrationData& calibration_data =
+      config_.key_switch_calibration_data[index];
+  KeySwitchCurve& curve = config_.key_switch_curves[index];
+  void* storage = key_switch_storage_[index].data;
+  switch (key_config.key_type) {
+    case 1:
+      key_switches_[index] =
+          new (storage) RapidTriggerKey(key_config, calibration_data, curve);
+      break;
+    case 2:
+      key_switches_[index] = new (storage) DynamicKeystrokeKey(
+          key_config, calibration_data, curve, config_.dynamic_keystrokes);
+      break;
+    case 0:
+    default:
+      key_switches_[index] =
+          new (storage) ThresholdKey(key_config, calibration_data, curve);
+      break;
+  }
+  key_types_[index] = key_config.key_type;
+  if (key_config.key_type == 2) {
+    dynamic_keys_ |= 1UL << index;
+  } else {
+    dynamic_keys_ &= ~(1UL << index);
+  }
+}
+
+void Keyboard::Task() {
+  uint32_t now = HAL_GetTick();
+  // Flash erase stalls the CPU for a while, do it only when idle.
+  if (now - last_active_tick_ < kSaveIdleTime) {
+    return;
+  }
+  if (config_.device_config.background_calibration &&
+      now - last_calibration_save_tick_ >= kCalibrationSaveInterval &&
+      IsCalibrationChanged()) {
+    KeySwitchCalibrationData calibration_data[32];
+    memcpy(calibration_data, config_.key_switch_calibration_data,
+           sizeof(calibration_data));
+    Flash::SaveCalibrationData(calibration_data);
+    memcpy(saved_calibration_data_, calibration_data,
+           sizeof(saved_calibration_data_));
+    last_calibration_save_tick_ = now;
+  }
+  if (now - last_usage_save_tick_ >= kUsageSaveInterval) {
+    SaveUsageStats();
+  }
+}
+
+void Keyboard::SaveUsageStats() {
+  if (!usage_.IsDirty()) {
+    return;
+  }
+  // Mark first so that a press during the write is saved next time.
+  usage_.MarkSaved();
+  Flash::SaveUsageStats(usage_.GetStats());
+  last_usage_save_tick_ = HAL_GetTick();
+}
+
+void Keyboard::MarkCalibrationSaved() {
+  memcpy(saved_calibration_data_, config_.key_switch_calibration_data,
+         sizeof(saved_calibration_data_));
+  last_calibration_save_tick_ = HAL_GetTick();
+}
+
+bool Keyboard::IsCalibrationChanged() const {
+  for (int i = 0; i < 32; i++) {
+    const KeySwitchCalibrationData& now = config_.key_switch_calibration_data[i];
+    const KeySwitchCalibrationData& saved = saved_calibration_data_[i];
+    if (abs(now.max_value - saved.max_value) >= kCalibrationSaveThreshold ||
+        abs(now.min_value - saved.min_value) >= kCalibrationSaveThreshold) {
+      return true;
     }
   }
+  return false;
 }
 
 void Keyboard::Update() {
-  uint8_t key_codes[6] = {0};
-  uint8_t modifier = 0;
-  uint8_t key_codes_count = 0;
-
   for (int i = 0; i < 32; i++) {
     // 型チェックと再生成
-    if (config_.key_switch_configs[i].key_type == 0) {
-      if (dynamic_cast<ThresholdKey*>(key_switches_[i]) == nullptr) {
-        delete key_switches_[i];
-        key_switches_[i] = new ThresholdKey(config_.key_switch_configs[i], config_.key_switch_calibration_data[i]);
-      }
-    } else if (config_.key_switch_configs[i].key_type == 1) {
-      if (dynamic_cast<RapidTriggerKey*>(key_switches_[i]) == nullptr) {
-        delete key_switches_[i];
-        key_switches_[i] = new RapidTriggerKey(config_.key_switch_configs[i], config_.key_switch_calibration_data[i]);
-      }
+    if (config_.key_switch_configs[i].key_type != key_types_[i]) {
+      CreateKeySwitch(i);
+      // The new key starts released without an edge.
+      resync_ = true;
     }
+    if (config_.key_switch_configs[i].switch_type != switch_types_[i]) {
+      ApplySwitchProfile(config_.key_switch_configs[i],
+                         config_.key_switch_curves[i]);
+      switch_types_[i] = config_.key_switch_configs[i].switch_type;
+    }
+  }
+  scan_count_ = scan_count_ + 1;
+  scan_timestamp_ = CycleCounter::Now();
+  scanned_ = true;
+  gamepad_scanned_ = true;
+}
 
-    if (key_switches_[i]->IsPressed()) {
-      uint8_t key_code = key_switches_[i]->GetKeyCode();
-      if (key_code < 0xE0) {
-        key_codes[key_codes_count++] = key_code;
+void Keyboard::SendReport() {
+  SendControlReport();
+  SendGamepadReport();
+  if (tx_state_ != TxState::kIdle) {
+    bool unread = boot_protocol_ && tx_instance_ != HID_INSTANCE_KEYBOARD;
+    if (!tud_hid_n_ready(tx_instance_) && !unread) {
+      if (!key_events_.Empty()) {
+        // Sent as one report when the transfer completes.
+        tx_state_ = TxState::kPending;
+      }
+      return;
+    }
+    // The endpoint is free but the transfer never completed (bus reset), or
+    // the host does not read the interface in boot protocol.
+    if (!unread) {
+      tx_stats_.stalls++;
+    }
+    tx_state_ = TxState::kIdle;
+    has_inflight_edge_ = false;
+    report_pending_ = true;
+  }
+  bool nkro = config_.device_config.report_mode != 0 && !boot_protocol_;
+  if (nkro != report_.IsNkro()) {
+    // Release the keys on the interface in use before switching, unless it
+    // is the NKRO interface that the host does not read in boot protocol.
+    uint8_t instance =
+        report_.IsNkro() ? HID_INSTANCE_NKRO : HID_INSTANCE_KEYBOARD;
+    bool release = !(boot_protocol_ && report_.IsNkro());
+    if (release && !tud_hid_n_ready(instance)) {
+      return;
+    }
+    bool sent = false;
+    if (release) {
+      if (report_.IsNkro()) {
+        uint8_t empty[ReportBuilder::kNkroReportSize] = {};
+        sent = tud_hid_n_report(instance, 0, empty, sizeof(empty));
       } else {
-        modifier |= (1 << (key_code - 0xE0));
+        sent = tud_hid_n_keyboard_report(instance, 0, 0, nullptr);
       }
+    }
+    // The held keys are added again to the new report.
+    report_.Reset(nkro);
+    if (sent) {
+      StartTransfer(instance);
+      return;
+    }
+  }
+  uint8_t instance = nkro ? HID_INSTANCE_NKRO : HID_INSTANCE_KEYBOARD;
+  if (!tud_hid_n_ready(instance)) {
+    // Not mounted or suspended. Keep the edges queued.
+    return;
+  }
+  uint32_t now = HAL_GetTick();
+  uint16_t keep_alive = config_.device_config.keep_alive_interval;
+  bool keep_alive_due =
+      keep_alive != 0 && now - last_report_tick_ >= keep_alive;
+  // The report changes only with a scan or a queued edge.
+  if (!scanned_.exchange(false) && key_events_.Empty() && !report_pending_ &&
+      !keep_alive_due) {
+    return;
+  }
+  uint32_t pressed;
+  uint8_t positions[32];
+  uint8_t report[ReportBuilder::kNkroReportSize];
+  uint8_t modifier;
+  // Update() recreates key switches from the timer interrupt, keep them
+  // alive while the report is built.
+  __disable_irq();
+  for (int i = 0; i < 32; i++) {
+    positions[i] = key_switches_[i]->GetLastPosition();
+  }
+  pressed = DrainKeyEvents();
+  pressed = socd_.Resolve(config_.socd_groups, pressed, positions);
+  if (report_.Update(pressed, dynamic_keys_, key_switches_)) {
+    report_pending_ = true;
+  }
+  if (nkro) {
+    memcpy(report, report_.GetNkroReport(), ReportBuilder::kNkroReportSize);
+  } else {
+    memcpy(report, report_.GetKeyCodes(), ReportBuilder::kReportKeys);
+  }
+  modifier = report_.GetModifier();
+  bool active = !report_.IsEmpty();
+  uint16_t consumer_usage = report_.GetConsumerUsage();
+  uint8_t system_control = report_.GetSystemControl();
+  __enable_irq();
 
-      if (key_codes_count == 6) {
-        break;
-      }
+  if (consumer_usage != consumer_usage_) {
+    consumer_usage_ = consumer_usage;
+    control_pending_ |= kConsumerPending;
+  }
+  if (system_control != system_control_) {
+    system_control_ = system_control;
+    control_pending_ |= kSystemPending;
+  }
+  SendControlReport();
+
+  if (active) {
+    last_active_tick_ = now;
+  }
+  if (!report_pending_ && !keep_alive_due) {
+    // Edges that did not change the report (e.g. SOCD) have no latency.
+    has_pending_edge_ = false;
+    return;
+  }
+  bool sent;
+  if (nkro) {
+    sent =
+        tud_hid_n_report(instance, 0, report, ReportBuilder::kNkroReportSize);
+  } else {
+    sent = tud_hid_n_keyboard_report(instance, 0, modifier, report);
+  }
+  if (!sent) {
+    // Still pending, retried on the next call.
+    return;
+  }
+  report_pending_ = false;
+  last_report_tick_ = now;
+  StartTransfer(instance);
+  if (has_pending_edge_) {
+    inflight_edge_timestamp_ = pending_edge_timestamp_;
+    has_inflight_edge_ = true;
+    has_pending_edge_ = false;
+  }
+}
+
+void Keyboard::SendControlReport() {
+  if (control_pending_ == 0 || !tud_hid_n_ready(HID_INSTANCE_CONTROL)) {
+    return;
+  }
+  if (control_pending_ & kConsumerPending) {
+    uint8_t report[2] = {static_cast<uint8_t>(consumer_usage_),
+                         static_cast<uint8_t>(consumer_usage_ >> 8)};
+    if (tud_hid_n_report(HID_INSTANCE_CONTROL, REPORT_ID_CONSUMER_CONTROL,
+                         report, sizeof(report))) {
+      control_pending_ &= ~kConsumerPending;
+    }
+    return;
+  }
+  if (tud_hid_n_report(HID_INSTANCE_CONTROL, REPORT_ID_SYSTEM_CONTROL,
+                       &system_control_, sizeof(system_control_))) {
+    control_pending_ &= ~kSystemPending;
+  }
+}
+
+void Keyboard::SendGamepadReport() {
+  if (!tud_hid_n_ready(HID_INSTANCE_GAMEPAD)) {
+    return;
+  }
+  if (gamepad_scanned_.exchange(false)) {
+    uint16_t travels[32] = {};
+    uint32_t keys = Gamepad::GetMappedKeys(config_.gamepad_axes);
+    // Update() recreates key switches from the timer interrupt.
+    __disable_irq();
+    while (keys != 0) {
+      uint8_t i = __builtin_ctz(keys);
+      keys &= keys - 1;
+      travels[i] = key_switches_[i]->GetLastTravel();
     }
+    __enable_irq();
+    if (gamepad_.Update(config_.gamepad_axes, travels)) {
+      gamepad_pending_ = true;
+    }
+  }
+  if (!gamepad_pending_) {
+    return;
+  }
+  const GamepadReport& report = gamepad_.GetReport();
+  if (tud_hid_n_report(HID_INSTANCE_GAMEPAD, REPORT_ID_GAMEPAD, &report,
+                       sizeof(report))) {
+    gamepad_pending_ = false;
   }
-  tud_hid_keyboard_report(0, modifier, key_codes);
+}
+
+void Keyboard::SetBootProtocol(bool boot) {
+  boot_protocol_ = boot;
+  // Send the keys held in the format of the protocol.
+  report_pending_ = true;
+}
+
+void Keyboard::StartTransfer(uint8_t instance) {
+  tx_state_ = TxState::kInFlight;
+  tx_instance_ = instance;
+  tx_stats_.transfers++;
+}
+
+void Keyboard::OnReportComplete(uint8_t instance) {
+  if (instance == HID_INSTANCE_CONTROL) {
+    SendControlReport();
+    return;
+  }
+  if (instance == HID_INSTANCE_GAMEPAD) {
+    SendGamepadReport();
+    return;
+  }
+  if (tx_state_ == TxState::kIdle || instance != tx_instance_) {
+    return;
+  }
+  if (tx_state_ == TxState::kPending) {
+    tx_stats_.coalesced++;
+  }
+  tx_state_ = TxState::kIdle;
+  if (has_inflight_edge_) {
+    has_inflight_edge_ = false;
+    RecordLatency(
+        CycleCounter::ToMicros(CycleCounter::Now() - inflight_edge_timestamp_));
+  }
+  // The endpoint is free, queue the next report for the next poll.
+  SendReport();
+}
+
+void Keyboard::RecordLatency(uint32_t us) {
+  ReportLatencyStats& stats = latency_stats_;
+  if (stats.samples == 0 || us < stats.min_us) {
+    stats.min_us = us;
+  }
+  if (us > stats.max_us) {
+    stats.max_us = us;
+  }
+  if (stats.total_us > UINT32_MAX - us) {
+    // Keep the average
+    stats.samples /= 2;
+    stats.total_us /= 2;
+  }
+  stats.samples++;
+  stats.total_us += us;
 }
 
 void Keyboard::SetADCValue(uint8_t adc_ch, uint8_t amux_channel,
@@ -64,7 +357,91 @@ void Keyboard::SetADCValue(uint8_t adc_ch, uint8_t amux_channel,
   if (index < 0 || 32 <= index) {
     return;
   }
-  key_switches_[index]->Update(value);
+  raw_values_[index] = value;
+  // Everything below sees the value falling as the key is pressed.
+  value ^= OrientationMask(index);
+  if (index == capture_index_ && capture_count_ < kCaptureSize) {
+    capture_buffer_[capture_count_] = value;
+    capture_count_ = capture_count_ + 1;
+  }
+  const KeySwitchConfig& key_config = config_.key_switch_configs[index];
+  const KeySwitchCalibrationData& calibration_data =
+      config_.key_switch_calibration_data[index];
+  KeySwitchBase* key_switch = key_switches_[index];
+  uint32_t bit = 1UL << index;
+  bool was_pressed = pressed_ & bit;
+  if (health_[index].Update(value, calibration_data)) {
+    uint16_t filtered = filters_[index].Update(value, key_config.filter_alpha,
+                                               key_config.filter_beta);
+    key_switch->Update(filtered);
+    if (config_.device_config.background_calibration) {
+      key_switch->TrackCalibration(filtered);
+    }
+  } else {
+    // Quarantined: the key sees the rest value and releases as usual.
+    key_switch->Update(calibration_data.max_value);
+  }
+  bool pressed = key_switch->IsPressed();
+  if (pressed != was_pressed) {
+    pressed_ ^= bit;
+    PushKeyEvent(index, pressed);
+  }
+  usage_.Update(index, pressed, key_switch->GetLastPosition(), HAL_GetTick());
+}
+
+void Keyboard::PushKeyEvent(uint8_t index, bool pressed) {
+  key_event_stats_.edges++;
+  if (!key_events_.Push({CycleCounter::Now(), index, pressed})) {
+    key_event_stats_.overflows++;
+    resync_ = true;
+    return;
+  }
+  uint16_t depth = key_events_.Size();
+  if (depth > key_event_stats_.high_water_mark) {
+    key_event_stats_.high_water_mark = depth;
+  }
+}
+
+uint32_t Keyboard::DrainKeyEvents() {
+  uint32_t toggled = 0;
+  KeyEvent event;
+  while (key_events_.Peek(event)) {
+    uint32_t bit = 1UL << event.index;
+    if (toggled & bit) {
+      // The second edge of the key goes to the next report.
+      break;
+    }
+    toggled |= bit;
+    if (!has_pending_edge_) {
+      pending_edge_timestamp_ = event.timestamp;
+      has_pending_edge_ = true;
+    }
+    if (event.pressed) {
+      reported_pressed_ |= bit;
+    } else {
+      reported_pressed_ &= ~bit;
+    }
+    key_events_.Pop();
+  }
+  if (key_events_.Empty() && resync_.exchange(false)) {
+    reported_pressed_ = pressed_;
+  }
+  return reported_pressed_;
+}
+
+KeyEventStats Keyboard::GetKeyEventStats() const {
+  KeyEventStats stats = key_event_stats_;
+  stats.depth = key_events_.Size();
+  return stats;
+}
+
+void Keyboard::StartCurveCapture(uint8_t index) {
+  if (32 <= index) {
+    return;
+  }
+  capture_index_ = -1;
+  capture_count_ = 0;
+  capture_index_ = index;
 }
 
 void Keyboard::StartCalibrate() {
@@ -74,8 +451,44 @@ void Keyboard::StartCalibrate() {
 }
 
 void Keyboard::StopCalibrate() {
+  // The ADC callbacks must not see a flipped calibration with the old
+  // orientation or the other way around.
+  __disable_irq();
   for (int i = 0; i < 32; i++) {
-    key_switches_[i]->StopCalibrate();
+    if (key_switches_[i]->StopCalibrate()) {
+      config_.device_config.inverted_keys ^= 1UL << i;
+      // Their state is of the other orientation.
+      filters_[i] = AlphaBetaFilter();
+      health_[i].Clear();
+    }
+  }
+  __enable_irq();
+}
+
+void Keyboard::StartNoiseMeasurement() {
+  for (int i = 0; i < 32; i++) {
+    key_switches_[i]->StartNoiseMeasurement();
+  }
+}
+
+void Keyboard::StopNoiseMeasurement() {
+  for (int i = 0; i < 32; i++) {
+    key_switches_[i]->StopNoiseMeasurement();
+  }
+}
+
+void Keyboard::ClearStats() {
+  for (int i = 0; i < 32; i++) {
+    key_switches_[i]->GetStats() = KeySwitchStats();
+  }
+  key_event_stats_ = KeyEventStats();
+  latency_stats_ = ReportLatencyStats();
+  tx_stats_ = HidTxStats();
+}
+
+void Keyboard::ClearFaults() {
+  for (int i = 0; i < 32; i++) {
+    health_[i].Clear();
   }
 }
 
@@ -179,26 +592,3 @@ int8_t Keyboard::ChToIndex(uint8_t adc_ch, uint8_t amux_channel) {
   return -1;
 }
 }  // namespace ember
-
-// TinyUSB callbacks
-// Invoked when received GET_REPORT control request
-// Application must fill buffer report's content and return its length.
-// Return zero will cause the stack to STALL request
-uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id,
-                               hid_report_type_t report_type, uint8_t* buffer,
-                               uint16_t reqlen) {
-  (void)instance;
-  (void)report_id;
-  (void)report_type;
-  (void)buffer;
-  (void)reqlen;
-  return 0;
-}
-
-// Invoked when received SET_REPORT control request or
-// received data on OUT endpoint ( Report ID = 0, Type = 0 )
-void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id,
-                           hid_report_type_t report_type, uint8_t const* buffer,
-                           uint16_t bufsize) {
-  (void)instance;
-}
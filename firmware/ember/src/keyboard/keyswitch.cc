@@ -4,10 +4,59 @@ namespace ember {
 void KeySwitchBase::StartCalibrate() {
   calibration_data_.max_value = 0;
   calibration_data_.min_value = 4095;
+  has_calibration_rest_ = false;
   is_calibrating_ = true;
+  // Reseed the background calibration from the new values.
+  rest_mean_ = 0;
+  bottom_samples_ = 0;
+}
+bool KeySwitchBase::StopCalibrate() {
+  if (!is_calibrating_) {
+    return false;
+  }
+  is_calibrating_ = false;
+  uint16_t max_value = calibration_data_.max_value;
+  uint16_t min_value = calibration_data_.min_value;
+  // A key that was not pressed tells nothing about its direction.
+  if (!has_calibration_rest_ || max_value < min_value + kMinCalibrationRange) {
+    return false;
+  }
+  // Rest is the end of the range the key started from.
+  if (max_value - calibration_rest_ >= calibration_rest_ - min_value) {
+    calibration_data_.max_value = 4095 - min_value;
+    calibration_data_.min_value = 4095 - max_value;
+    return true;
+  }
+  return false;
+}
+void KeySwitchBase::StartNoiseMeasurement() {
+  stats_.top_noise = 0;
+  stats_.bottom_noise = 0;
+  is_bottom_measured_ = false;
+  noise_window_samples_ = 0;
+  is_measuring_noise_ = true;
+}
+void KeySwitchBase::StopNoiseMeasurement() {
+  if (!is_measuring_noise_) {
+    return;
+  }
+  is_measuring_noise_ = false;
+  // One step of margin above the largest deviation seen.
+  uint8_t top = stats_.top_noise + 1;
+  config_.top_deadzone =
+      top < kMaxSuggestedDeadzone ? top : kMaxSuggestedDeadzone;
+  if (is_bottom_measured_) {
+    // Keep the current value if the key was never bottomed out.
+    uint8_t bottom = stats_.bottom_noise + 1;
+    config_.bottom_deadzone =
+        bottom < kMaxSuggestedDeadzone ? bottom : kMaxSuggestedDeadzone;
+  }
 }
-void KeySwitchBase::StopCalibrate() { is_calibrating_ = false; }
 void KeySwitchBase::Calibrate(uint16_t value) {
+  if (!has_calibration_rest_) {
+    calibration_rest_ = value;
+    has_calibration_rest_ = true;
+  }
   if (value > calibration_data_.max_value) {
     calibration_data_.max_value = value;
   }
@@ -16,89 +65,376 @@ void KeySwitchBase::Calibrate(uint16_t value) {
   }
 }
 
-uint8_t KeySwitchBase::ADCValToDistance(uint16_t value) {
-  if (value < calibration_data_.min_value) {
-    return 40;
+void KeySwitchBase::TrackCalibration(uint16_t value) {
+  if (is_calibrating_ || is_measuring_noise_) {
+    return;
   }
-  if (value > calibration_data_.max_value) {
-    return 0;
+  // Deeper than the known bottom. The bottom only moves after
+  // kBottomSamples such readings in a row, and only to the shallowest of
+  // them, so that spikes never widen the range. Readings more than 1/4 of
+  // the range below are left to SensorHealth.
+  uint16_t range = calibration_data_.max_value > calibration_data_.min_value
+                       ? calibration_data_.max_value - calibration_data_.min_value
+                       : 0;
+  if (value < calibration_data_.min_value &&
+      value + range / 4 >= calibration_data_.min_value) {
+    if (bottom_samples_ == 0 || value > bottom_value_) {
+      bottom_value_ = value;
+    }
+    if (++bottom_samples_ >= kBottomSamples) {
+      calibration_data_.min_value = bottom_value_;
+      bottom_samples_ = 0;
+    }
+    idle_samples_ = 0;
+    return;
+  }
+  bottom_samples_ = 0;
+  // Idle: released and not moving. The slow time constant keeps a finger
+  // resting on the key for a while from dragging the rest value.
+  if (is_pressed_ || velocity_ > kIdleVelocity || velocity_ < -kIdleVelocity) {
+    idle_samples_ = 0;
+    return;
+  }
+  if (idle_samples_ < kIdleSamples) {
+    idle_samples_++;
+    return;
+  }
+  int32_t sample = static_cast<int32_t>(value) << 16;
+  if (rest_mean_ == 0) {
+    // Seed the deviation so that max_value does not jump.
+    rest_mean_ = sample;
+    int32_t margin = calibration_data_.max_value > value
+                         ? calibration_data_.max_value - value
+                         : 0;
+    rest_deviation_ = (margin << 16) / kRestMargin;
+    return;
+  }
+  int32_t error = sample - rest_mean_;
+  rest_mean_ += error >> kRestMeanShift;
+  int32_t abs_error = error < 0 ? -error : error;
+  rest_deviation_ += (abs_error - rest_deviation_) >> kRestDeviationShift;
+
+  int32_t max_value = (rest_mean_ + kRestMargin * rest_deviation_) >> 16;
+  if (max_value > 4095) {
+    max_value = 4095;
   }
+  if (max_value < calibration_data_.min_value + kMinCalibrationRange) {
+    return;
+  }
+  calibration_data_.max_value = max_value;
+}
 
-  // a was precalculated by fitting the curve
-  // distance vs ADC value data is needed to calculate
-  float a = 200;
-  float b = log((calibration_data_.max_value - calibration_data_.min_value) / a + 1) / 4;
-  return log((calibration_data_.max_value - value) / a + 1) * 10 / b;
+void KeySwitchBase::SetPressed(bool pressed) {
+  if (pressed == is_pressed_) {
+    return;
+  }
+  if (pressed) {
+    // last_release_sample_ is 0 until the first release.
+    if (last_release_sample_ != 0 &&
+        sample_count_ - last_release_sample_ < kChatterWindow) {
+      stats_.chatter_count++;
+    }
+  } else {
+    last_release_sample_ = sample_count_;
+  }
+  is_pressed_ = pressed;
 }
 
-bool ThresholdKey::Update(uint16_t value) {
+bool KeySwitchBase::Update(uint16_t value) {
   if (is_calibrating_) {
     Calibrate(value);
     return false;
   }
-  last_position_ = ADCValToDistance(value);
-  if (last_position_ > config_.actuation_point) {
-    is_pressed_ = true;
+  sample_count_++;
+  last_value_ = value;
+  uint8_t position = ADCValToDistance(value);
+  if (is_measuring_noise_) {
+    MeasureNoise(position);
+  }
+  last_position_ = ApplyDeadzone(position);
+  UpdateVelocity(last_position_);
+  CheckPrediction(last_position_);
+  return UpdateState(last_position_);
+}
+
+void KeySwitchBase::UpdateVelocity(uint8_t position) {
+  // Central difference over the last three samples, in 1/4 of 0.1mm/sample.
+  velocity_ = (static_cast<int16_t>(position) - position_history_[0]) * 2;
+  position_history_[0] = position_history_[1];
+  position_history_[1] = position;
+}
+
+bool KeySwitchBase::PredictCrossing(uint8_t position, uint8_t threshold,
+                                    bool press) const {
+  if (config_.predictive_velocity == 0) {
+    return false;
+  }
+  int16_t min_velocity = config_.predictive_velocity * 4;
+  if ((press ? velocity_ : -velocity_) < min_velocity) {
+    return false;
+  }
+  // All values in 1/4 of 0.1mm
+  int32_t projected =
+      position * 4 + velocity_ * config_.predictive_horizon / 4;
+  return press ? projected > threshold * 4 : projected <= threshold * 4;
+}
+
+void KeySwitchBase::SetPredictedPressed(bool pressed, uint8_t threshold) {
+  SetPressed(pressed);
+  stats_.predicted_edges++;
+  prediction_.samples_left = kPredictionWindow;
+  prediction_.pressed = pressed;
+  prediction_.threshold = threshold;
+}
+
+void KeySwitchBase::CheckPrediction(uint8_t position) {
+  if (prediction_.samples_left == 0) {
+    return;
+  }
+  bool crossed = prediction_.pressed ? position > prediction_.threshold
+                                     : position <= prediction_.threshold;
+  if (crossed) {
+    stats_.confirmed_edges++;
+    prediction_.samples_left = 0;
+    return;
+  }
+  prediction_.samples_left--;
+  if (prediction_.samples_left == 0 && is_pressed_ == prediction_.pressed) {
+    // False positive: the key stopped short of the threshold.
+    OnPredictionFailed();
+  }
+}
+
+uint8_t KeySwitchBase::ApplyDeadzone(uint8_t position) const {
+  if (position <= config_.top_deadzone) {
+    return 0;
+  }
+  uint8_t travel = Travel();
+  if (position + config_.bottom_deadzone >= travel) {
+    return travel;
+  }
+  return position;
+}
+
+void KeySwitchBase::MeasureNoise(uint8_t position) {
+  uint8_t low = noise_window_samples_ == 0 || position < noise_window_min_
+                    ? position
+                    : noise_window_min_;
+  uint8_t high = noise_window_samples_ == 0 || position > noise_window_max_
+                     ? position
+                     : noise_window_max_;
+  if (high - low > kNoiseStillness) {
+    // The key moved, start a new window from this sample.
+    low = position;
+    high = position;
+    noise_window_samples_ = 0;
+  }
+  noise_window_min_ = low;
+  noise_window_max_ = high;
+  if (noise_window_samples_ < kNoiseWindow) {
+    noise_window_samples_++;
+    return;
+  }
+  // At rest long enough, the spread of the window is noise.
+  if (high < kNoiseZone) {
+    if (high > stats_.top_noise) {
+      stats_.top_noise = high;
+    }
+  } else if (low + kNoiseZone > Travel()) {
+    uint8_t depth = Travel() - low;
+    if (depth > stats_.bottom_noise) {
+      stats_.bottom_noise = depth;
+    }
+    is_bottom_measured_ = true;
+  }
+}
+
+uint8_t KeySwitchBase::ADCValToDistance(uint16_t value) const {
+  uint8_t travel = Travel();
+  if (value <= calibration_data_.min_value) {
+    return travel;
+  }
+  if (value >= calibration_data_.max_value) {
+    return 0;
+  }
+  uint16_t depth = ADCValToDepth(value);
+  if (depth <= curve_.knots[0]) {
+    return 0;
+  }
+  uint8_t i = FindCurveSegment(depth);
+  if (i == kCurveKnots) {
+    return travel;
+  }
+  // Knot i is at i * travel / (kCurveKnots - 1), rounded once at the end.
+  uint32_t span = curve_.knots[i] - curve_.knots[i - 1];
+  uint32_t offset = depth - curve_.knots[i - 1];
+  uint32_t scale = (kCurveKnots - 1) * span;
+  return (((i - 1) * span + offset) * travel + scale / 2) / scale;
+}
+
+uint16_t KeySwitchBase::ADCValToDepth(uint16_t value) const {
+  // 0 at the top and kCurveScale at the bottom
+  return static_cast<uint32_t>(calibration_data_.max_value - value) *
+         kCurveScale /
+         (calibration_data_.max_value - calibration_data_.min_value);
+}
+
+uint8_t KeySwitchBase::FindCurveSegment(uint16_t depth) const {
+  uint8_t i = 1;
+  while (i < kCurveKnots && depth >= curve_.knots[i]) {
+    i++;
+  }
+  return i;
+}
+
+uint16_t KeySwitchBase::GetLastTravel() const {
+  uint16_t value = last_value_;
+  if (is_calibrating_ || value >= calibration_data_.max_value) {
+    return 0;
+  }
+  if (value <= calibration_data_.min_value) {
+    return kCurveScale;
+  }
+  uint16_t depth = ADCValToDepth(value);
+  if (depth <= curve_.knots[0]) {
+    return 0;
+  }
+  uint8_t i = FindCurveSegment(depth);
+  if (i == kCurveKnots) {
+    return kCurveScale;
+  }
+  // Same interpolation as ADCValToDistance() without the rounding to 0.1mm.
+  // offset < span, offset * kCurveScale fits in 32 bits.
+  uint32_t span = curve_.knots[i] - curve_.knots[i - 1];
+  uint32_t offset = depth - curve_.knots[i - 1];
+  return ((i - 1) * static_cast<uint32_t>(kCurveScale) +
+          offset * kCurveScale / span) /
+         (kCurveKnots - 1);
+}
+
+bool ThresholdKey::UpdateState(uint8_t position) {
+  if (prediction_.samples_left > 0) {
+    // Wait for the predicted edge to be confirmed or reverted.
+    return is_pressed_;
+  }
+  if (!is_pressed_) {
+    if (position > config_.actuation_point) {
+      SetPressed(true);
+    } else if (PredictCrossing(position, config_.actuation_point, true)) {
+      SetPredictedPressed(true, config_.actuation_point);
+    }
   } else {
-    is_pressed_ = false;
+    if (position <= ReleasePoint()) {
+      SetPressed(false);
+    } else if (PredictCrossing(position, ReleasePoint(), false)) {
+      SetPredictedPressed(false, ReleasePoint());
+    }
   }
   return is_pressed_;
 }
 
-bool RapidTriggerKey::Update(uint16_t value) {
-  if (is_calibrating_) {
-    Calibrate(value);
-    return false;
+void RapidTriggerKey::OnPredictionFailed() {
+  state_ = State::kRest;
+  SetPressed(false);
+}
+
+bool RapidTriggerKey::UpdateOutsideZone(uint8_t position, uint8_t edge) {
+  // The part of the move up to the limit still counts, so that a fast lift
+  // out of the top in one scan releases the key.
+  if (state_ == State::kRapidTriggerDown &&
+      peek_value_ - edge > config_.rappid_trigger_up_sensivity) {
+    state_ = State::kRapidTriggerUp;
+    SetPressed(false);
+  } else if (state_ == State::kRapidTriggerUp &&
+             edge - peek_value_ > config_.rappid_trigger_down_sensivity) {
+    state_ = State::kRapidTriggerDown;
+    SetPressed(true);
   }
+  if (position <= ReleasePoint()) {
+    state_ = State::kRest;
+    SetPressed(false);
+    return is_pressed_;
+  }
+  // Beyond the bottom the key is pressed past the actuation point. Above the
+  // top a key released by rapid trigger stays released until it comes back.
+  if (!is_pressed_ && position > edge && position > config_.actuation_point) {
+    state_ = State::kRapidTriggerDown;
+    SetPressed(true);
+  }
+  // Rapid trigger resumes relative to the zone limit, so that noise near
+  // the bottom does not release the key right when it comes back.
+  peek_value_ = edge;
+  return is_pressed_;
+}
 
-  last_position_ = ADCValToDistance(value);
+bool RapidTriggerKey::UpdateState(uint8_t position) {
+  if (state_ != State::kRest) {
+    uint8_t upper = config_.rappid_trigger_upper_limit;
+    uint8_t lower = config_.rappid_trigger_lower_limit != 0
+                        ? config_.rappid_trigger_lower_limit
+                        : Travel();
+    if (position < upper) {
+      return UpdateOutsideZone(position, upper);
+    }
+    if (position > lower) {
+      return UpdateOutsideZone(position, lower);
+    }
+  }
   switch (state_) {
     case State::kRest:
       // Trigger
-      if (last_position_ > config_.actuation_point) {
-        peek_value_ = last_position_;
+      if (position > config_.actuation_point) {
+        peek_value_ = position;
+        state_ = State::kRapidTriggerDown;
+        SetPressed(true);
+        return is_pressed_;
+      }
+      // Predicted trigger. Only the first actuation is predicted, the rapid
+      // trigger edges are already relative to the peak.
+      if (PredictCrossing(position, config_.actuation_point, true)) {
+        peek_value_ = position;
         state_ = State::kRapidTriggerDown;
-        is_pressed_ = true;
+        SetPredictedPressed(true, config_.actuation_point);
         return is_pressed_;
       }
       break;
     case State::kRapidTriggerDown:
       // Back to rest state
-      if (last_position_ <= config_.actuation_point) {
+      if (position <= ReleasePoint()) {
         state_ = State::kRest;
-        is_pressed_ = false;
+        SetPressed(false);
         return is_pressed_;
       }
       // Release trigger
-      if (peek_value_ - last_position_ > config_.rappid_trigger_up_sensivity) {
-        peek_value_ = last_position_;
+      if (peek_value_ - position > config_.rappid_trigger_up_sensivity) {
+        peek_value_ = position;
         state_ = State::kRapidTriggerUp;
-        is_pressed_ = false;
+        SetPressed(false);
         return is_pressed_;
       }
       // Update peek_value
-      if (peek_value_ < last_position_) {
-        peek_value_ = last_position_;
+      if (peek_value_ < position) {
+        peek_value_ = position;
       }
       break;
     case State::kRapidTriggerUp:
       // Back to rest state
-      if (last_position_ <= config_.actuation_point) {
+      if (position <= ReleasePoint()) {
         state_ = State::kRest;
-        is_pressed_ = false;
+        SetPressed(false);
         return is_pressed_;
       }
       // Trigger
-      if (last_position_ - peek_value_ >
+      if (position - peek_value_ >
           config_.rappid_trigger_down_sensivity) {
-        peek_value_ = last_position_;
+        peek_value_ = position;
         state_ = State::kRapidTriggerDown;
-        is_pressed_ = true;
+        SetPressed(true);
         return is_pressed_;
       }
       // Update peek_value
-      if (peek_value_ > last_position_) {
-        peek_value_ = last_position_;
+      if (peek_value_ > position) {
+        peek_value_ = position;
       }
       break;
     default:
@@ -107,4 +443,54 @@ bool RapidTriggerKey::Update(uint16_t value) {
   return is_pressed_;
 }
 
+uint8_t DynamicKeystrokeKey::GetKeyCodes(
+    uint8_t (&key_codes)[kMaxKeyCodes]) const {
+  const DynamicKeystrokeConfig* slot = Slot();
+  uint8_t count = 0;
+  for (int i = 0; slot != nullptr && i < kDynamicKeystrokeActions; i++) {
+    if (reported_actions_ & (1 << i)) {
+      key_codes[count++] = slot->actions[i].key_code;
+    }
+  }
+  return count;
+}
+
+bool DynamicKeystrokeKey::UpdateState(uint8_t position) {
+  const DynamicKeystrokeConfig* slot = Slot();
+  if (slot == nullptr) {
+    active_actions_ = 0;
+    reported_actions_ = 0;
+    SetPressed(false);
+    return is_pressed_;
+  }
+  for (int i = 0; i < kDynamicKeystrokeActions; i++) {
+    const DynamicKeystrokeAction& action = slot->actions[i];
+    uint8_t bit = 1 << i;
+    uint8_t release_point = action.release_point < action.press_point
+                                ? action.release_point
+                                : action.press_point;
+    if (action.key_code == 0 || position <= release_point) {
+      active_actions_ &= ~bit;
+    } else if (position > action.press_point) {
+      active_actions_ |= bit;
+    }
+  }
+  // Deeper actions hide the shallower ones while they are pressed.
+  uint8_t hidden = 0;
+  for (int i = 0; i < kDynamicKeystrokeActions; i++) {
+    const DynamicKeystrokeAction& action = slot->actions[i];
+    if (!(active_actions_ & (1 << i)) || !(action.flags & kReleaseShallower)) {
+      continue;
+    }
+    for (int j = 0; j < kDynamicKeystrokeActions; j++) {
+      if (slot->actions[j].press_point < action.press_point) {
+        hidden |= 1 << j;
+      }
+    }
+  }
+  reported_actions_ = active_actions_ & ~hidden;
+  SetPressed(reported_actions_ != 0);
+  return is_pressed_;
+}
+
 }  // namespace ember
@@ -0,0 +1,231 @@
+#include "ember/keyboard/report_builder.h"
+
+#include <cstring>
+
+namespace ember {
+namespace {
+// Consumer Page usages of KC_AUDIO_MUTE~KC_BRIGHTNESS_DOWN
+constexpr uint16_t kConsumerUsages[] = {
+    0x00E2,  // Mute
+    0x00E9,  // Volume Increment
+    0x00EA,  // Volume Decrement
+    0x00B5,  // Scan Next Track
+    0x00B6,  // Scan Previous Track
+    0x00B7,  // Stop
+    0x00CD,  // Play/Pause
+    0x0183,  // AL Consumer Control Configuration
+    0x00B8,  // Eject
+    0x018A,  // AL Email Reader
+    0x0192,  // AL Calculator
+    0x0194,  // AL Local Machine Browser
+    0x0221,  // AC Search
+    0x0223,  // AC Home
+    0x0224,  // AC Back
+    0x0225,  // AC Forward
+    0x0226,  // AC Stop
+    0x0227,  // AC Refresh
+    0x022A,  // AC Bookmarks
+    0x00B3,  // Fast Forward
+    0x00B4,  // Rewind
+    0x006F,  // Display Brightness Increment
+    0x0070,  // Display Brightness Decrement
+};
+static_assert(sizeof(kConsumerUsages) / sizeof(kConsumerUsages[0]) ==
+                  KC_BRIGHTNESS_DOWN - KC_AUDIO_MUTE + 1,
+              "A consumer usage is needed for each media key code");
+}  // namespace
+
+bool ReportBuilder::Update(uint32_t pressed, uint32_t dynamic_keys,
+                           KeySwitchBase* const (&key_switches)[32]) {
+  // Pressed keys that did not fit stay in here and are retried.
+  uint32_t changed = pressed ^ reported_;
+  uint32_t dynamic = pressed & reported_ & dynamic_keys;
+  if (changed == 0 && dynamic == 0) {
+    return false;
+  }
+  uint8_t codes[KeySwitchBase::kMaxKeyCodes];
+  // Dynamic keys that send other codes now are released and pressed again.
+  while (dynamic != 0) {
+    uint8_t i = __builtin_ctz(dynamic);
+    dynamic &= dynamic - 1;
+    uint8_t count = key_switches[i]->GetKeyCodes(codes);
+    uint8_t modifiers = 0;
+    uint8_t matched = 0;
+    // Codes that did not fit stay out until the codes of the key change.
+    uint8_t skipped = 0;
+    bool same = true;
+    for (int j = 0; j < count && same; j++) {
+      if (codes[j] >= 0xE0) {
+        modifiers |= 1 << (codes[j] - 0xE0);
+      } else if (codes[j] == 0) {
+        continue;
+      } else if (matched < key_report_counts_[i] &&
+                 key_report_codes_[i][matched] == codes[j]) {
+        matched++;
+      } else if (skipped < key_dropped_counts_[i] &&
+                 key_dropped_codes_[i][skipped] == codes[j]) {
+        skipped++;
+      } else {
+        same = false;
+      }
+    }
+    if (!same || matched != key_report_counts_[i] ||
+        skipped != key_dropped_counts_[i] ||
+        modifiers != key_modifiers_[i]) {
+      changed |= 1UL << i;
+    }
+  }
+  bool report_changed = false;
+  // Releases first so that the new keys can take their slots.
+  uint32_t released = changed & reported_;
+  while (released != 0) {
+    uint8_t i = __builtin_ctz(released);
+    released &= released - 1;
+    if (RemoveKey(i)) {
+      report_changed = true;
+    }
+  }
+  uint32_t added = changed & pressed;
+  while (added != 0) {
+    uint8_t i = __builtin_ctz(added);
+    added &= added - 1;
+    uint8_t count = key_switches[i]->GetKeyCodes(codes);
+    if (AddKey(i, codes, count)) {
+      report_changed = true;
+    }
+  }
+  nkro_report_[kNkroReportSize - 1] = modifier_;
+  return report_changed;
+}
+
+void ReportBuilder::Reset(bool nkro) {
+  *this = ReportBuilder();
+  nkro_ = nkro;
+}
+
+bool ReportBuilder::RemoveKey(uint8_t index) {
+  reported_ &= ~(1UL << index);
+  uint8_t removed = key_report_counts_[index];
+  // A usage of the NKRO report stays while another key holds it.
+  bool codes_changed = false;
+  for (int j = 0; j < removed; j++) {
+    uint8_t code = key_report_codes_[index][j];
+    if (IsControlCode(code)) {
+      RemoveControlCode(code);
+      continue;
+    }
+    if (nkro_) {
+      if (--nkro_refs_[code] == 0) {
+        nkro_report_[code >> 3] &= ~(1 << (code & 7));
+        key_count_--;
+        codes_changed = true;
+      }
+      continue;
+    }
+    for (int k = 0; k < key_count_; k++) {
+      if (key_codes_[k] == code) {
+        // Keep the remaining keys in press order.
+        memmove(&key_codes_[k], &key_codes_[k + 1], key_count_ - k - 1);
+        key_codes_[--key_count_] = 0;
+        codes_changed = true;
+        break;
+      }
+    }
+  }
+  key_report_counts_[index] = 0;
+  key_dropped_counts_[index] = 0;
+  if (key_modifiers_[index] == 0) {
+    return codes_changed;
+  }
+  key_modifiers_[index] = 0;
+  // Another held key may share the modifier.
+  uint8_t modifier = 0;
+  uint32_t keys = reported_;
+  while (keys != 0) {
+    uint8_t i = __builtin_ctz(keys);
+    keys &= keys - 1;
+    modifier |= key_modifiers_[i];
+  }
+  bool changed = codes_changed || modifier != modifier_;
+  modifier_ = modifier;
+  return changed;
+}
+
+bool ReportBuilder::AddKey(uint8_t index, const uint8_t* codes,
+                           uint8_t count) {
+  uint8_t modifiers = 0;
+  uint8_t added = 0;
+  uint8_t dropped = 0;
+  bool codes_changed = false;
+  for (int j = 0; j < count; j++) {
+    uint8_t code = codes[j];
+    if (code >= 0xE0) {
+      modifiers |= 1 << (code - 0xE0);
+    } else if (code == 0) {
+      continue;
+    } else if (IsControlCode(code)) {
+      // Not limited by the slots of the keyboard report
+      control_refs_[code - KC_SYSTEM_POWER]++;
+      if (IsSystemCode(code)) {
+        system_code_ = code;
+      } else {
+        consumer_code_ = code;
+      }
+      key_report_codes_[index][added++] = code;
+    } else if (nkro_) {
+      if (nkro_refs_[code]++ == 0) {
+        nkro_report_[code >> 3] |= 1 << (code & 7);
+        key_count_++;
+        codes_changed = true;
+      }
+      key_report_codes_[index][added++] = code;
+    } else if (key_count_ < kReportKeys) {
+      key_codes_[key_count_++] = code;
+      key_report_codes_[index][added++] = code;
+      codes_changed = true;
+    } else {
+      key_dropped_codes_[index][dropped++] = code;
+    }
+  }
+  if (dropped != 0 && added == 0 && modifiers == 0) {
+    // Not reported, retried on the next call.
+    return false;
+  }
+  // A key without codes (e.g. Dynamic Keystroke before its first action) is
+  // reported as nothing so that it is not looked at again.
+  reported_ |= 1UL << index;
+  key_report_counts_[index] = added;
+  key_dropped_counts_[index] = dropped;
+  key_modifiers_[index] = modifiers;
+  bool changed = codes_changed || (modifier_ | modifiers) != modifier_;
+  modifier_ |= modifiers;
+  return changed;
+}
+
+void ReportBuilder::RemoveControlCode(uint8_t code) {
+  if (--control_refs_[code - KC_SYSTEM_POWER] != 0 ||
+      (code != consumer_code_ && code != system_code_)) {
+    return;
+  }
+  // Fall back to another held code of the same kind.
+  uint8_t replacement = 0;
+  for (uint8_t c = KC_SYSTEM_POWER; c <= KC_BRIGHTNESS_DOWN; c++) {
+    if (control_refs_[c - KC_SYSTEM_POWER] != 0 &&
+        IsSystemCode(c) == IsSystemCode(code)) {
+      replacement = c;
+    }
+  }
+  if (IsSystemCode(code)) {
+    system_code_ = replacement;
+  } else {
+    consumer_code_ = replacement;
+  }
+}
+
+uint16_t ReportBuilder::GetConsumerUsage() const {
+  if (consumer_code_ == 0) {
+    return 0;
+  }
+  return kConsumerUsages[consumer_code_ - KC_AUDIO_MUTE];
+}
+}  // namespace ember
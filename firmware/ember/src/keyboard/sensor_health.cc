@@ -0,0 +1,108 @@
+#include "ember/keyboard/sensor_health.h"
+
+#include <cstdlib>
+
+namespace ember {
+bool SensorHealth::Update(uint16_t value,
+                          const KeySwitchCalibrationData& calibration_data) {
+  if (!primed_) {
+    last_value_[0] = value;
+    last_value_[1] = value;
+    primed_ = true;
+    return !IsQuarantined();
+  }
+  bool healthy = true;
+
+  // Stuck. A steady value inside the calibration range is a held key, only
+  // one outside of it or at a rail that is not the calibrated bottom is
+  // suspicious.
+  bool calibrated = calibration_data.max_value > calibration_data.min_value;
+  bool at_rail = (value == 0 || value == 4095) &&
+                 !(calibrated && value == calibration_data.min_value);
+  bool outside = calibrated && (value > calibration_data.max_value ||
+                                value < calibration_data.min_value);
+  if (value == last_value_[1] && (at_rail || outside)) {
+    if (stuck_samples_ < kStuckSamples) {
+      stuck_samples_++;
+    } else {
+      Fail(kStuck);
+      healthy = false;
+    }
+  } else {
+    stuck_samples_ = 0;
+  }
+
+  // Out of calibration range. Skipped while the range is being calibrated.
+  uint16_t slew_limit = kMaxSlew;
+  // Lowest value of the rest band, the key is at rest above it.
+  int32_t rest_value = 0;
+  if (calibrated) {
+    uint16_t range = calibration_data.max_value - calibration_data.min_value;
+    rest_value = calibration_data.max_value - range / kRestBand;
+    if (range > kMinSlew) {
+      slew_limit = range;
+    }
+    int32_t margin = range / 4 > kMinRangeMargin ? range / 4 : kMinRangeMargin;
+    if (value > calibration_data.max_value + margin ||
+        value + margin < calibration_data.min_value) {
+      if (out_of_range_samples_ < kOutOfRangeSamples) {
+        out_of_range_samples_++;
+      } else {
+        Fail(kOutOfRange);
+        healthy = false;
+      }
+    } else {
+      out_of_range_samples_ = 0;
+    }
+  }
+
+  // Noise, only while the last three samples are at rest. The start and the
+  // stop of a stroke give large second differences, so fast tapping would
+  // otherwise read as noise.
+  if (value >= rest_value && last_value_[1] >= rest_value &&
+      last_value_[0] >= rest_value) {
+    int32_t second_difference = value - 2 * last_value_[1] + last_value_[0];
+    int32_t abs_second_difference = abs(second_difference) << 4;
+    noise_ += (abs_second_difference - noise_) >> kNoiseShift;
+  }
+  if (noise_ > kMaxNoise << 4) {
+    Fail(kNoisy);
+    healthy = false;
+  }
+
+  // Slew rate
+  if (abs(value - last_value_[1]) > slew_limit) {
+    slew_count_++;
+    slew_decay_ = 0;
+  } else if (slew_count_ > 0 && ++slew_decay_ >= kSlewDecaySamples) {
+    slew_count_--;
+    slew_decay_ = 0;
+  }
+  if (slew_count_ >= kSlewLimit) {
+    Fail(kSlew);
+    healthy = false;
+  }
+
+  last_value_[0] = last_value_[1];
+  last_value_[1] = value;
+
+  if (!healthy) {
+    healthy_samples_ = 0;
+  } else if (IsQuarantined() && ++healthy_samples_ >= kRecoverySamples) {
+    flags_ &= ~kQuarantined;
+  }
+  return !IsQuarantined();
+}
+
+void SensorHealth::Fail(uint8_t fault) { flags_ |= fault | kQuarantined; }
+
+void SensorHealth::Clear() {
+  flags_ = 0;
+  stuck_samples_ = 0;
+  out_of_range_samples_ = 0;
+  noise_ = 0;
+  slew_count_ = 0;
+  slew_decay_ = 0;
+  healthy_samples_ = 0;
+}
+}  // namespace ember
@@ -0,0 +1,72 @@
+#include "ember/keyboard/socd.h"
+
+namespace ember {
+uint32_t SocdResolver::Resolve(const SocdGroupConfig (&groups)[kSocdGroups],
+                               uint32_t pressed,
+                               const uint8_t (&positions)[32]) {
+  // Number the new presses. Keys pressed in the same scan share the order
+  // and are told apart by travel.
+  uint32_t new_presses = pressed & ~last_pressed_;
+  if (new_presses != 0) {
+    press_counter_++;
+    for (int i = 0; i < 32; i++) {
+      if (new_presses & (1UL << i)) {
+        press_order_[i] = press_counter_;
+      }
+    }
+  }
+  last_pressed_ = pressed;
+
+  uint32_t result = pressed;
+  uint32_t grouped = 0;
+  for (int g = 0; g < kSocdGroups; g++) {
+    const SocdGroupConfig& group = groups[g];
+    // Keys already in an earlier group are not resolved again.
+    uint32_t mask = group.key_mask & ~grouped;
+    grouped |= mask;
+    uint32_t active = pressed & mask;
+    if (group.policy == kDisabled || group.policy > kDeepest ||
+        (active & (active - 1)) == 0) {
+      // Disabled, or less than two keys pressed
+      continue;
+    }
+    int winner = -1;
+    for (int i = 0; i < 32; i++) {
+      if (!(active & (1UL << i))) {
+        continue;
+      }
+      if (winner < 0) {
+        winner = i;
+        continue;
+      }
+      bool newer = press_order_[i] > press_order_[winner] ||
+                   (press_order_[i] == press_order_[winner] &&
+                    positions[i] > positions[winner]);
+      bool older = press_order_[i] < press_order_[winner] ||
+                   (press_order_[i] == press_order_[winner] &&
+                    positions[i] > positions[winner]);
+      switch (group.policy) {
+        case kLastInput:
+          if (newer) winner = i;
+          break;
+        case kFirstInput:
+          if (older) winner = i;
+          break;
+        case kDeepest:
+          if (positions[i] > positions[winner] ||
+              (positions[i] == positions[winner] && newer)) {
+            winner = i;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    result &= ~mask;
+    if (group.policy != kNeutral && winner >= 0) {
+      result |= 1UL << winner;
+    }
+  }
+  return result;
+}
+}  // namespace ember
@@ -0,0 +1,49 @@
+#include "ember/keyboard/switch_profile.h"
+
+namespace ember {
+namespace {
+// The curves are (exp(k * x) - 1) / (exp(k) - 1) of the travel fraction x,
+// the shape of Flash::MakeLogCurve. k is about 1.83 for the stock magnet
+// (the default curve), larger for stronger magnets and 0 for linear sensors.
+constexpr SwitchProfile kSwitchProfiles[kSwitchTypes] = {
+    // Custom
+    {40, 1, 1, 2, 2, {}},
+    // Standard 4.0mm (k = 1.83)
+    {40, 1, 1, 2, 2,
+     {{0, 3216, 7260, 12344, 18735, 26770, 36871, 49570, kCurveScale}}},
+    // Short 3.5mm, strong magnet (k = 2.5)
+    {35, 1, 2, 1, 1,
+     {{0, 2150, 5088, 9105, 14595, 22098, 32355, 46374, kCurveScale}}},
+    // Low profile 3.0mm, weak magnet (k = 1.2)
+    {30, 2, 2, 2, 2,
+     {{0, 4571, 9882, 16053, 23222, 31551, 41229, 52472, kCurveScale}}},
+    // Linear response 4.0mm (k = 0)
+    {40, 1, 1, 1, 1,
+     {{0, 8192, 16384, 24576, 32768, 40959, 49151, 57343, kCurveScale}}},
+};
+}  // namespace
+
+const SwitchProfile& GetSwitchProfile(uint8_t switch_type) {
+  return kSwitchProfiles[switch_type < kSwitchTypes ? switch_type : 0];
+}
+
+void ApplySwitchProfile(KeySwitchConfig& config, KeySwitchCurve& curve) {
+  if (config.switch_type == 0 || config.switch_type >= kSwitchTypes) {
+    return;
+  }
+  const SwitchProfile& profile = kSwitchProfiles[config.switch_type];
+  curve = profile.curve;
+  config.top_deadzone = profile.top_deadzone;
+  config.bottom_deadzone = profile.bottom_deadzone;
+  config.rappid_trigger_up_sensivity = profile.rappid_trigger_up_sensivity;
+  config.rappid_trigger_down_sensivity = profile.rappid_trigger_down_sensivity;
+  // A point at or past the bottom deadzone would never be reached.
+  uint8_t deepest = profile.travel - profile.bottom_deadzone - 1;
+  if (config.actuation_point > deepest) {
+    config.actuation_point = deepest;
+  }
+  if (config.release_point > deepest) {
+    config.release_point = deepest;
+  }
+}
+}  // namespace ember
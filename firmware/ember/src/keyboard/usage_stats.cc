@@ -0,0 +1,49 @@
+#include "ember/keyboard/usage_stats.h"
+
+namespace ember {
+void UsageRecorder::Update(uint8_t index, bool pressed, uint8_t position,
+                           uint32_t tick) {
+  uint32_t bit = 1UL << index;
+  if (pressed) {
+    if (!(pressed_ & bit)) {
+      pressed_ |= bit;
+      press_tick_[index] = tick;
+      max_position_[index] = 0;
+    }
+    if (position > max_position_[index]) {
+      max_position_[index] = position;
+    }
+    return;
+  }
+  if (!(pressed_ & bit)) {
+    return;
+  }
+  pressed_ &= ~bit;
+
+  KeyUsage& usage = stats_.keys[index];
+  usage.actuations++;
+  uint32_t dwell = tick - press_tick_[index];
+  uint8_t dwell_bucket = 0;
+  for (uint32_t limit = kFirstDwellBucket;
+       dwell_bucket < kUsageBuckets - 1 && dwell >= limit; limit <<= 1) {
+    dwell_bucket++;
+  }
+  // Histogram buckets saturate
+  if (usage.dwell_histogram[dwell_bucket] != UINT16_MAX) {
+    usage.dwell_histogram[dwell_bucket]++;
+  }
+  uint8_t depth_bucket = max_position_[index] / kDepthBucket;
+  if (depth_bucket >= kUsageBuckets) {
+    depth_bucket = kUsageBuckets - 1;
+  }
+  if (usage.depth_histogram[depth_bucket] != UINT16_MAX) {
+    usage.depth_histogram[depth_bucket]++;
+  }
+  dirty_ = true;
+}
+
+void UsageRecorder::Clear() {
+  stats_ = UsageStats();
+  dirty_ = true;
+}
+}  // namespace ember
@@ -1,15 +1,38 @@
 #include "ember/module/flash.h"
 
+#include <cmath>
+
 #include "SEGGER_RTT.h"
 #include "ember/keyboard/keycodes.h"
 
 namespace ember {
 void Flash::SaveConfig(const Config& config) {
+  Program(kFlashStartAddress, &config, sizeof(Config));
+  SEGGER_RTT_printf(0, "Save config done.\n");
+}
+
+void Flash::SaveUsageStats(const UsageStats& stats) {
+  Program(kUsageStatsAddress, &stats, sizeof(UsageStats));
+  SEGGER_RTT_printf(0, "Save usage stats done.\n");
+}
+
+bool Flash::LoadUsageStats(UsageStats& stats) {
+  memcpy(&stats, reinterpret_cast<const void*>(kUsageStatsAddress),
+         sizeof(UsageStats));
+  if (stats.magic != kUsageStatsMagic ||
+      stats.version != kUsageStatsVersion) {
+    stats = UsageStats();
+    return false;
+  }
+  return true;
+}
+
+void Flash::Program(uint32_t address, const void* data, size_t size) {
   HAL_FLASH_Unlock();
   FLASH_EraseInitTypeDef erase;
   erase.TypeErase = FLASH_TYPEERASE_PAGES;
-  erase.PageAddress = 0x801F800;
-  erase.NbPages = 2;
+  erase.PageAddress = address;
+  erase.NbPages = 1;
   uint32_t page_error = 0;
   auto result = HAL_FLASHEx_Erase(&erase, &page_error);
   if (result != HAL_OK || page_error != 0xFFFFFFFF) {
@@ -17,19 +40,26 @@ void Flash::SaveConfig(const Config& config) {
   } else {
     SEGGER_RTT_printf(0, "Erase done.\n");
   }
-  // const uint16_t* data = reinterpret_cast<const uint16_t*>(&config);
-  uint16_t data[sizeof(Config) / 2];
-  for (int i = 0; i < sizeof(Config) / 2; i++) {
-    data[i] = reinterpret_cast<const uint16_t*>(&config)[i];
-  }
-
-  for (int i = 0; i < sizeof(Config) / 2; i++) {
+  // The structs are packed, read them byte by byte instead of copying them
+  // to the stack.
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size / 2; i++) {
+    uint16_t half_word = bytes[i * 2] | bytes[i * 2 + 1] << 8;
     HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD,
-                      kFlashStartAddress + i * sizeof(uint16_t), data[i]);
+                      address + i * sizeof(uint16_t), half_word);
   }
-
   HAL_FLASH_Lock();
-  SEGGER_RTT_printf(0, "Save config done.\n");
+}
+
+void Flash::SaveCalibrationData(
+    const KeySwitchCalibrationData (&calibration_data)[32]) {
+  // Only the calibration is replaced so that unsaved edits from the
+  // configurator are not persisted behind the user's back.
+  static Config stored;
+  LoadConfig(stored);
+  memcpy(stored.key_switch_calibration_data, calibration_data,
+         sizeof(stored.key_switch_calibration_data));
+  SaveConfig(stored);
 }
 
 bool Flash::LoadConfig(Config& config) {
@@ -41,9 +71,144 @@ bool Flash::LoadConfig(Config& config) {
     memcpy(&config, &default_config, sizeof(Config));
     return false;
   }
+  if (!MigrateConfig(config)) {
+    SEGGER_RTT_printf(0, "Unknown config version, load default config.\n");
+    Config default_config = GetDefaultConfig();
+    memcpy(&config, &default_config, sizeof(Config));
+    return false;
+  }
+  return true;
+}
+
+bool Flash::MigrateConfig(Config& config) {
+  if (config.header.magic != kConfigMagic) {
+    MigrateLegacyConfig(config);
+    return true;
+  }
+  if (config.header.version > kConfigVersion) {
+    return false;
+  }
+  // Migration steps, oldest first. New fields were reserved (zero) bytes.
+  if (config.header.version < 3) {
+    for (int i = 0; i < 32; i++) {
+      KeySwitchConfig& key_config = config.key_switch_configs[i];
+      key_config.top_deadzone = KeySwitchConfig().top_deadzone;
+      key_config.bottom_deadzone = KeySwitchConfig().bottom_deadzone;
+    }
+  }
+  if (config.header.version < 4) {
+    for (int i = 0; i < 32; i++) {
+      KeySwitchConfig& key_config = config.key_switch_configs[i];
+      key_config.predictive_velocity = KeySwitchConfig().predictive_velocity;
+      key_config.predictive_horizon = KeySwitchConfig().predictive_horizon;
+    }
+  }
+  if (config.header.version < 5) {
+    for (int i = 0; i < 32; i++) {
+      KeySwitchConfig& key_config = config.key_switch_configs[i];
+      key_config.filter_alpha = KeySwitchConfig().filter_alpha;
+      key_config.filter_beta = KeySwitchConfig().filter_beta;
+    }
+  }
+  if (config.header.version < 6) {
+    // Older images end before the device config, the bytes read are erased
+    // flash.
+    config.device_config = DeviceConfig();
+  }
+  if (config.header.version < 7) {
+    // Keep the conversion of the older firmware for the stored calibration.
+    for (int i = 0; i < 32; i++) {
+      config.key_switch_curves[i] =
+          MakeLogCurve(config.key_switch_calibration_data[i]);
+    }
+  }
+  if (config.header.version < 8) {
+    SetDefaultSocdGroups(config);
+  }
+  if (config.header.version < 9) {
+    for (int i = 0; i < 32; i++) {
+      config.key_switch_configs[i].dynamic_keystroke_slot =
+          KeySwitchConfig().dynamic_keystroke_slot;
+    }
+    for (int i = 0; i < kDynamicKeystrokeSlots; i++) {
+      config.dynamic_keystrokes[i] = DynamicKeystrokeConfig();
+    }
+  }
+  if (config.header.version < 13) {
+    config.device_config.polling_interval =
+        DeviceConfig().polling_interval;
+  }
+  if (config.header.version < 14) {
+    config.device_config.report_mode = DeviceConfig().report_mode;
+  }
+  if (config.header.version < 16) {
+    // Older images end before the gamepad axes, the bytes read are erased
+    // flash.
+    for (int i = 0; i < kGamepadAxes; i++) {
+      config.gamepad_axes[i] = GamepadAxisConfig();
+    }
+  }
+  config.header.version = kConfigVersion;
   return true;
 }
 
+void Flash::MigrateLegacyConfig(Config& config) {
+  // Version 1 layout (288 bytes, no header)
+  struct LegacyKeySwitchConfig {
+    uint8_t key_code;
+    uint8_t key_type;
+    uint8_t actuation_point;
+    uint8_t rappid_trigger_up_sensivity;
+    uint8_t rappid_trigger_down_sensivity;
+  } __attribute__((packed));
+  struct LegacyConfig {
+    LegacyKeySwitchConfig key_switch_configs[32];
+    KeySwitchCalibrationData key_switch_calibration_data[32];
+  } __attribute__((packed));
+
+  LegacyConfig legacy;
+  memcpy(&legacy, reinterpret_cast<const void*>(kFlashStartAddress),
+         sizeof(LegacyConfig));
+
+  config = Config();
+  for (int i = 0; i < 32; i++) {
+    const LegacyKeySwitchConfig& src = legacy.key_switch_configs[i];
+    KeySwitchConfig& dst = config.key_switch_configs[i];
+    dst.key_code = src.key_code;
+    dst.key_type = src.key_type;
+    dst.actuation_point = src.actuation_point;
+    dst.rappid_trigger_up_sensivity = src.rappid_trigger_up_sensivity;
+    dst.rappid_trigger_down_sensivity = src.rappid_trigger_down_sensivity;
+    // Legacy firmware released at the actuation point.
+    dst.release_point = src.actuation_point;
+    config.key_switch_calibration_data[i] =
+        legacy.key_switch_calibration_data[i];
+    config.key_switch_curves[i] =
+        MakeLogCurve(config.key_switch_calibration_data[i]);
+  }
+  SetDefaultSocdGroups(config);
+  SEGGER_RTT_printf(0, "Migrated legacy config.\n");
+}
+
+KeySwitchCurve Flash::MakeLogCurve(
+    const KeySwitchCalibrationData& calibration_data) {
+  // Inverse of distance = log((max - value) / a + 1) / log(range / a + 1),
+  // the conversion used up to version 6.
+  constexpr float a = 200;
+  KeySwitchCurve curve;
+  if (calibration_data.max_value <= calibration_data.min_value) {
+    return curve;
+  }
+  float range = calibration_data.max_value - calibration_data.min_value;
+  float b = log(range / a + 1);
+  for (int i = 0; i < kCurveKnots; i++) {
+    float depth = (exp(b * i / (kCurveKnots - 1)) - 1) * a / range;
+    curve.knots[i] = depth * kCurveScale + 0.5f;
+  }
+  curve.knots[kCurveKnots - 1] = kCurveScale;
+  return curve;
+}
+
 Config Flash::GetDefaultConfig() {
   Config default_config;
   uint8_t default_key_map_[32] = {
@@ -60,6 +225,16 @@ Config Flash::GetDefaultConfig() {
   default_config.key_switch_configs[16].key_type = 1;
   default_config.key_switch_configs[17].key_type = 1;
   default_config.key_switch_configs[18].key_type = 1;
+  SetDefaultSocdGroups(default_config);
   return default_config;
 }
+
+void Flash::SetDefaultSocdGroups(Config& config) {
+  // A/D and W/S of the default keymap, disabled until a policy is chosen.
+  for (int i = 0; i < kSocdGroups; i++) {
+    config.socd_groups[i] = SocdGroupConfig();
+  }
+  config.socd_groups[0].key_mask = (1UL << 16) | (1UL << 18);
+  config.socd_groups[1].key_mask = (1UL << 10) | (1UL << 17);
+}
 }  // namespace ember
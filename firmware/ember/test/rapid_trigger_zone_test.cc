@@ -0,0 +1,100 @@
+// Zone transitions of RapidTriggerKey (rappid_trigger_upper_limit,
+// rappid_trigger_lower_limit): entering and leaving the top and the bottom
+// limits while the key is pressed and while it is released.
+#include <cstdio>
+#include <initializer_list>
+
+#include "ember/keyboard/keyswitch.h"
+
+namespace ember {
+namespace {
+// Feeds positions (0.1mm, deadzones applied) straight to the state machine.
+class TestKey : public RapidTriggerKey {
+ public:
+  using RapidTriggerKey::RapidTriggerKey;
+  bool Feed(uint8_t position) { return UpdateState(position); }
+};
+
+struct Step {
+  uint8_t position;
+  bool pressed;
+};
+
+int failures = 0;
+
+// Actuation 1.0mm, release 0.8mm, rapid trigger 0.2mm both ways, 4.0mm
+// travel. upper = 0 and lower = 0 disable the limits.
+void Run(const char* name, uint8_t upper, uint8_t lower,
+         std::initializer_list<Step> steps) {
+  KeySwitchConfig config;
+  config.key_type = 1;
+  config.actuation_point = 10;
+  config.release_point = 8;
+  config.rappid_trigger_up_sensivity = 2;
+  config.rappid_trigger_down_sensivity = 2;
+  config.rappid_trigger_upper_limit = upper;
+  config.rappid_trigger_lower_limit = lower;
+  KeySwitchCalibrationData calibration_data;
+  KeySwitchCurve curve;
+  TestKey key(config, calibration_data, curve);
+  int i = 0;
+  for (const Step& step : steps) {
+    bool pressed = key.Feed(step.position);
+    if (pressed != step.pressed) {
+      printf("FAIL %s: step %d (position %d) pressed %d, expected %d\n", name,
+             i, step.position, pressed, step.pressed);
+      failures++;
+      return;
+    }
+    i++;
+  }
+  printf("ok   %s\n", name);
+}
+}  // namespace
+}  // namespace ember
+
+int main() {
+  using ember::failures;
+  using ember::Run;
+  // Without limits rapid trigger works over the whole travel.
+  Run("no limits", 0, 0,
+      {{5, false}, {11, true}, {20, true}, {17, false}, {20, true},
+       {40, true}, {37, false}, {8, false}});
+
+  // Zone 1.5mm~3.5mm. Rapid trigger edges need more than 0.2mm of travel.
+  // Top limit
+  Run("pressed, leaves top: threshold release only", 15, 35,
+      {{11, true}, {16, true}, {14, true}, {12, true}, {9, true}, {8, false}});
+  // 0.5mm of the 0.6mm lift is inside the zone, more than the sensitivity.
+  Run("pressed, leaves top in one scan: rapid trigger release", 15, 35,
+      {{11, true}, {20, true}, {14, false}, {12, false}, {14, false},
+       {18, true}});
+  Run("pressed, enters top: rapid trigger from the limit", 15, 35,
+      {{11, true}, {14, true}, {16, true}, {13, true}, {15, true},
+       {20, true}, {18, true}, {17, false}});
+  Run("released, leaves top: stays released", 15, 35,
+      {{11, true}, {25, true}, {22, false}, {16, false}, {12, false},
+       {14, false}, {8, false}, {11, true}});
+  Run("released, enters top: first actuation", 15, 35,
+      {{5, false}, {9, false}, {16, true}, {14, true}, {8, false}});
+
+  // Bottom limit. The limit is deeper than the actuation point, so a key
+  // beyond it is always pressed.
+  Run("pressed, leaves bottom: noise does not release", 15, 35,
+      {{11, true}, {40, true}, {37, true}, {40, true}, {36, true}});
+  Run("pressed, enters bottom: rapid trigger from the limit", 15, 35,
+      {{11, true}, {40, true}, {36, true}, {34, true}, {33, true},
+       {32, false}, {35, true}});
+  Run("released, leaves bottom: threshold press", 15, 35,
+      {{11, true}, {25, true}, {22, false}, {38, true}, {40, true},
+       {32, false}});
+
+  // An upper limit shallower than the actuation point: the key releases at
+  // the release point outside the zone and actuates again as usual.
+  Run("upper limit below actuation", 5, 0,
+      {{11, true}, {20, true}, {17, false}, {6, false}, {4, false},
+       {11, true}});
+
+  printf(failures == 0 ? "All tests passed\n" : "%d failures\n", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,8 @@
+// Host build stand-in for the CubeMX main.h. The code under test does not
+// use the HAL.
+#ifndef EMBER_TEST_STUBS_MAIN_H_
+#define EMBER_TEST_STUBS_MAIN_H_
+
+#include <stdint.h>
+
+#endif  // EMBER_TEST_STUBS_MAIN_H_
@@ -7,16 +7,35 @@ device_name = 'COM3'
 ser = serial.Serial(device_name, timeout=1)
 
 if len(sys.argv) == 1:
-    print("Usage: python serial_test_calibration.py [option=start|stop|save]")
+    print("Usage: python serial_test_calibration.py [option=start|stop|save|background-on|background-off|show]")
     exit(1)
 
-result = 1
+result = False
 if sys.argv[1] == "save":
     result = ember_write(ser, 0x3000, [0x00])
 elif sys.argv[1] == "stop":
     result = ember_write(ser, 0x3000, [0x00])
 elif sys.argv[1] == "start":
     result = ember_write(ser, 0x3001, [0x01])
+elif sys.argv[1] == "background-on":
+    result = ember_write(ser, DEVICE_CONFIG_ADDRESS, [0x01])
+elif sys.argv[1] == "background-off":
+    result = ember_write(ser, DEVICE_CONFIG_ADDRESS, [0x00])
+elif sys.argv[1] == "show":
+    device_config = ember_read(ser, DEVICE_CONFIG_ADDRESS, 5)
+    calibration = ember_read(ser, 0x1000, 128)
+    if device_config is None or calibration is None:
+        print("Failed to read calibration")
+        exit(1)
+    print("Background calibration: {}".format("on" if device_config[0] else "off"))
+    inverted_keys = int.from_bytes(bytes(device_config[1:5]), "little")
+    for key_id in range(32):
+        max_value = calibration[key_id * 4] | calibration[key_id * 4 + 1] << 8
+        min_value = calibration[key_id * 4 + 2] | calibration[key_id * 4 + 3] << 8
+        inverted = inverted_keys >> key_id & 1
+        print("Key {:2d}: max {:4d} min {:4d}{}".format(key_id, max_value, min_value, " (inverted)" if inverted else ""))
+    ser.close()
+    exit(0)
 
-print("Success" if result == 0 else "Failure")
+print("Success" if result else "Failure")
 ser.close()
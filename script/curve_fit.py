@@ -0,0 +1,155 @@
+import csv
+import serial
+import statistics
+import struct
+import sys
+import time
+from ember_serial import *
+
+# Capture the ADC value vs travel curve of a key and write its KeySwitchCurve.
+# The curve mirrors ember::KeySwitchCurve (include/ember/keyboard/config.h):
+# knot i is the normalized depth (rest - value) / (rest - bottom) * 65535 at
+# i / 8 of the travel, i * 0.5mm for 4.0mm switches.
+#
+# Usage:
+#   python curve_fit.py capture key_id trace.csv
+#       Record a press of the key at the scan rate (about 1.4s).
+#   python curve_fit.py sweep key_id trace.csv [--write]
+#       Fit a capture of a press at constant speed (e.g. a linear stage).
+#   python curve_fit.py steps key_id [--write]
+#       Hold the key at each depth (e.g. with 0.5mm shims) when asked.
+#   python curve_fit.py show key_id
+# Options:
+#   --travel=3.5  Full travel of the switch in mm (default 4.0)
+
+CURVE_ADDRESS = 0x1100
+CURVE_KNOTS = 9
+CURVE_SIZE = CURVE_KNOTS * 2
+CURVE_SCALE = 65535
+KNOT_STEP_MM = 0.5
+CAPTURE_SIZE = 1024
+READ_CHUNK = 128
+
+
+def read_capture(ser, key_id):
+    ember_write(ser, 0x3007, [key_id + 1])
+    print("Press the key slowly to the bottom and release it...")
+    while True:
+        count = ember_read(ser, 0x4100, 2)
+        if count is not None and struct.unpack("<H", bytes(count))[0] >= CAPTURE_SIZE:
+            break
+        time.sleep(0.1)
+    ember_write(ser, 0x3007, [0x00])
+    data = b""
+    for address in range(0x5000, 0x5000 + CAPTURE_SIZE * 2, READ_CHUNK):
+        chunk = ember_read(ser, address, READ_CHUNK)
+        if chunk is None:
+            print("Failed to read capture")
+            exit(1)
+        data += bytes(chunk)
+    return list(struct.unpack("<{}H".format(CAPTURE_SIZE), data))
+
+
+def fit_sweep(samples):
+    # Rest and bottom from the ends of the press
+    rest = statistics.median(samples[:32])
+    bottom = min(samples)
+    noise = max(8, (rest - bottom) * 0.01)
+    start = next(i for i, v in enumerate(samples) if v < rest - noise)
+    # Walk back to the last sample at rest
+    while start > 0 and samples[start - 1] < rest:
+        start -= 1
+    end = next(i for i, v in enumerate(samples) if v <= bottom + noise)
+    if end <= start:
+        raise ValueError("no press found in the capture")
+    # Travel is linear in time between start and end
+    knots = []
+    for k in range(CURVE_KNOTS):
+        index = start + (end - start) * k / (CURVE_KNOTS - 1)
+        window = samples[max(0, round(index) - 2):round(index) + 3]
+        knots.append(statistics.median(window))
+    return normalize(knots, rest, bottom)
+
+
+def fit_steps(ser, key_id):
+    values = []
+    for k in range(CURVE_KNOTS):
+        input("Hold key {} at {:.1f}mm and press Enter...".format(key_id, k * KNOT_STEP_MM))
+        readings = []
+        for _ in range(32):
+            raw = ember_read(ser, 0x2100 + key_id * 2, 2)
+            if raw is not None:
+                readings.append(struct.unpack("<H", bytes(raw))[0])
+            time.sleep(0.005)
+        values.append(statistics.median(readings))
+    return normalize(values, values[0], values[-1])
+
+
+def normalize(values, rest, bottom):
+    knots = [0]
+    for v in values[1:-1]:
+        depth = round((rest - v) / (rest - bottom) * CURVE_SCALE)
+        # Knots must increase for the interpolation on the device
+        knots.append(min(max(depth, knots[-1] + 1), CURVE_SCALE - 1))
+    knots.append(CURVE_SCALE)
+    return knots
+
+
+def write_curve(ser, key_id, knots):
+    data = list(struct.pack("<{}H".format(CURVE_KNOTS), *knots))
+    if not ember_write(ser, CURVE_ADDRESS + key_id * CURVE_SIZE, data):
+        print("Failed to write curve")
+        exit(1)
+    print("Written. Save the config (0x3000) to keep it.")
+
+
+def print_curve(knots):
+    for k, knot in enumerate(knots):
+        print("{:.1f}mm: {:5d} ({:5.1f}%)".format(k * KNOT_STEP_MM, knot, knot / CURVE_SCALE * 100))
+
+
+if len(sys.argv) < 3:
+    print("Usage: python curve_fit.py [capture|sweep|steps|show] key_id [trace.csv] [--write] [--travel=mm]")
+    exit(1)
+
+mode = sys.argv[1]
+key_id = int(sys.argv[2])
+write = "--write" in sys.argv
+for arg in sys.argv:
+    if arg.startswith("--travel="):
+        KNOT_STEP_MM = float(arg[len("--travel="):]) / (CURVE_KNOTS - 1)
+
+if mode == "sweep":
+    with open(sys.argv[3]) as f:
+        samples = [int(row[1]) for row in csv.reader(f) if row[0].isdigit()]
+    knots = fit_sweep(samples)
+    print_curve(knots)
+    if not write:
+        exit(0)
+
+# open serial port
+device_name = 'COM3'
+ser = serial.Serial(device_name, timeout=1)
+
+if mode == "capture":
+    samples = read_capture(ser, key_id)
+    with open(sys.argv[3], "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["sample", "value"])
+        for i, v in enumerate(samples):
+            writer.writerow([i, v])
+elif mode == "sweep":
+    write_curve(ser, key_id, knots)
+elif mode == "steps":
+    knots = fit_steps(ser, key_id)
+    print_curve(knots)
+    if write:
+        write_curve(ser, key_id, knots)
+elif mode == "show":
+    data = ember_read(ser, CURVE_ADDRESS + key_id * CURVE_SIZE, CURVE_SIZE)
+    if data is None:
+        print("Failed to read curve")
+        exit(1)
+    print_curve(struct.unpack("<{}H".format(CURVE_KNOTS), bytes(data)))
+
+ser.close()
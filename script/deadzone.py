@@ -0,0 +1,35 @@
+import serial
+import sys
+from ember_serial import *
+
+# open serial port
+device_name = 'COM3'
+ser = serial.Serial(device_name, timeout=1)
+
+if len(sys.argv) == 1:
+    print("Usage: python deadzone.py [option=start|stop|show]")
+    print("  start: start measuring noise. Rest all keys, then hold each key bottomed out for a moment.")
+    print("  stop : stop measuring and apply the suggested deadzones.")
+    print("  show : show the deadzones of all keys.")
+    exit(1)
+
+result = 0
+if sys.argv[1] == "start":
+    result = ember_write(ser, 0x3006, [0x01])
+elif sys.argv[1] == "stop":
+    result = ember_write(ser, 0x3006, [0x00])
+elif sys.argv[1] == "show":
+    noise = ember_read(ser, 0x4040, 64)
+    for key_id in range(32):
+        key_config = ember_read(ser, 0x0000 + key_id * KEY_CONFIG_SIZE, 8)
+        if key_config is None or noise is None:
+            print("Failed to read key config")
+            exit(1)
+        print("Key {:2d}: top {:.1f}mm bottom {:.1f}mm (noise top {:.1f}mm bottom {:.1f}mm)".format(
+            key_id, key_config[6] / 10, key_config[7] / 10,
+            noise[key_id * 2] / 10, noise[key_id * 2 + 1] / 10))
+    ser.close()
+    exit(0)
+
+print("Success" if result else "Failure")
+ser.close()
@@ -0,0 +1,54 @@
+import serial
+import sys
+from ember_serial import *
+
+# open serial port
+device_name = 'COM3'
+ser = serial.Serial(device_name, timeout=1)
+
+DKS_ADDRESS = 0x1A00
+DKS_SLOT_SIZE = 16
+DKS_ACTIONS = 4
+DKS_ACTION_SIZE = 4
+
+if len(sys.argv) == 1:
+    print("Usage: python dynamic_keystroke.py show slot")
+    print("       python dynamic_keystroke.py set slot action key_code press_mm release_mm [replace]")
+    print("       python dynamic_keystroke.py assign key_id slot")
+    print("  replace: release the shallower actions while this action is pressed")
+    exit(1)
+
+result = False
+if sys.argv[1] == "show":
+    slot = int(sys.argv[2])
+    data = ember_read(ser, DKS_ADDRESS + slot * DKS_SLOT_SIZE, DKS_SLOT_SIZE)
+    if data is None:
+        print("Failed to read dynamic keystroke slot")
+        exit(1)
+    for i in range(DKS_ACTIONS):
+        key_code, press_point, release_point, flags = data[i * DKS_ACTION_SIZE:(i + 1) * DKS_ACTION_SIZE]
+        if key_code == 0:
+            print("Action {}: unused".format(i))
+            continue
+        print("Action {}: key_code 0x{:02X} press {:.1f}mm release {:.1f}mm{}".format(
+            i, key_code, press_point / 10, release_point / 10, " replace" if flags & 1 else ""))
+    ser.close()
+    exit(0)
+elif sys.argv[1] == "set":
+    slot = int(sys.argv[2])
+    action = int(sys.argv[3])
+    key_code = int(sys.argv[4], 0)
+    press_point = round(float(sys.argv[5]) * 10)
+    release_point = round(float(sys.argv[6]) * 10)
+    flags = 1 if "replace" in sys.argv[7:] else 0
+    address = DKS_ADDRESS + slot * DKS_SLOT_SIZE + action * DKS_ACTION_SIZE
+    result = ember_write(ser, address, [key_code, press_point, release_point, flags])
+elif sys.argv[1] == "assign":
+    key_id = int(sys.argv[2])
+    slot = int(sys.argv[3])
+    address = key_id * KEY_CONFIG_SIZE
+    # dynamic_keystroke_slot, then key_type
+    result = ember_write(ser, address + 0x0C, [slot]) and ember_write(ser, address + 0x01, [0x02])
+
+print("Success" if result else "Failure")
+ser.close()
@@ -1,6 +1,21 @@
 import serial
 from cobs import cobs
 
+# Size of a KeySwitchConfig entry in the 0x0000 region
+KEY_CONFIG_SIZE = 16
+# DeviceConfig region
+DEVICE_CONFIG_ADDRESS = 0x1800
+# Status byte of the frames pushed for a subscription
+PUSH_STATUS = 0x02
+
+
+def _read_response(ser: serial.Serial):
+    # Skip the frames pushed for subscriptions
+    while True:
+        response = cobs.decode(ser.read_until(b'\x00')[:-1])
+        if len(response) == 0 or response[0] != PUSH_STATUS:
+            return response
+
 
 def ember_write(ser: serial.Serial, address, data):
     write_query = []
@@ -12,23 +27,58 @@ def ember_write(ser: serial.Serial, address, data):
     write_query = cobs.encode(bytes(write_query)) + b'\x00'
     ser.write(write_query)
     ser.flush()
-    response = cobs.decode(ser.read_until(b'\x00')[:-1])
-    return response[0] == 0
+    response = _read_response(ser)
+    return len(response) > 0 and response[0] == 0
 
-def ember_read(ser: serial.Serial, address, len):
+def ember_read(ser: serial.Serial, address, length):
     read_query = []
     read_query.append(0x00)
     read_query.append(address >> 8)
     read_query.append(address & 0xFF)
-    read_query.append(len)
+    read_query.append(length)
     read_query = cobs.encode(bytes(read_query)) + b'\x00'
     ser.write(read_query)
     ser.flush()
-    response = cobs.decode(ser.read_until(b'\x00')[:-1])
-    if response[0] != 0:
+    response = _read_response(ser)
+    if len(response) < 4 or response[0] != 0:
         return None
     if response[1] << 8 | response[2] != address:
         return None
-    if response[3] != len:
+    if response[3] != length:
         return None
     return response[4:]
+
+def ember_subscribe(ser: serial.Serial, address, stride, key_mask=0xFFFFFFFF, interval=10):
+    """Push the values of the keys in key_mask every interval ms.
+    address is the per-key region (e.g. 0x2000, 0x2100, 0x4040) and stride
+    the bytes per key. interval = 0 unsubscribes."""
+    query = [0x02, address >> 8, address & 0xFF, 6, interval, stride]
+    query += list(key_mask.to_bytes(4, 'little'))
+    query = cobs.encode(bytes(query)) + b'\x00'
+    ser.write(query)
+    ser.flush()
+    return _read_response(ser)[:1] == b'\x00'
+
+def ember_unsubscribe(ser: serial.Serial, address):
+    return ember_subscribe(ser, address, 0, 0, 0)
+
+def ember_read_push(ser: serial.Serial, stride):
+    """Wait for a pushed frame.
+    Returns (address, tick in ms, {key: value bytes}) or None on timeout."""
+    while True:
+        frame = ser.read_until(b'\x00')
+        if not frame.endswith(b'\x00'):
+            return None
+        push = cobs.decode(frame[:-1])
+        if len(push) < 12 or push[0] != PUSH_STATUS:
+            continue
+        address = push[1] << 8 | push[2]
+        tick = int.from_bytes(push[4:8], 'little')
+        key_mask = int.from_bytes(push[8:12], 'little')
+        values = {}
+        offset = 12
+        for key in range(32):
+            if key_mask >> key & 1:
+                values[key] = push[offset:offset + stride]
+                offset += stride
+        return address, tick, values
@@ -0,0 +1,148 @@
+import csv
+import math
+import random
+import sys
+
+# Noise / lag trade-off of the per-key alpha-beta filter on recorded traces.
+# The filter below mirrors ember::AlphaBetaFilter (include/ember/keyboard/filter.h).
+#
+# Usage:
+#   python filter_benchmark.py trace.csv [key_id]   (recorded by record_trace.py)
+#   python filter_benchmark.py --synthetic
+
+FRACTION_BITS = 8
+MAX_POSITION = 4095 << FRACTION_BITS
+
+# (alpha, beta) pairs in 1/256 unit. alpha = 0 is the unfiltered reference.
+GAINS = [(0, 0), (192, 64), (160, 40), (128, 32), (96, 16), (64, 8), (32, 2)]
+
+
+class AlphaBetaFilter:
+    def __init__(self):
+        self.position = 0
+        self.velocity = 0
+        self.initialized = False
+
+    def update(self, value, alpha, beta):
+        measured = value << FRACTION_BITS
+        if alpha == 0 or not self.initialized:
+            self.position = measured
+            self.velocity = 0
+            self.initialized = True
+            return value
+        predicted = self.position + self.velocity
+        residual = measured - predicted
+        # Python >> on negative numbers is arithmetic, like the firmware.
+        self.position = predicted + ((alpha * residual) >> 8)
+        self.velocity += (beta * residual) >> 8
+        self.position = min(max(self.position, 0), MAX_POSITION)
+        return (self.position + (1 << (FRACTION_BITS - 1))) >> FRACTION_BITS
+
+
+def moving_average(values, n):
+    out = []
+    window = []
+    for v in values:
+        window.append(v)
+        if len(window) > n:
+            window.pop(0)
+        out.append(sum(window) // len(window))
+    return out
+
+
+def idle_indices(raw, rest, span, settle=16):
+    # Samples where the raw value stayed near rest for the last `settle`
+    # samples, so that the filter has settled after a stroke.
+    result = []
+    run = 0
+    for i, v in enumerate(raw):
+        run = run + 1 if abs(v - rest) < span * 0.02 else 0
+        if run >= settle:
+            result.append(i)
+    return result
+
+
+def rest_noise(values, rest, idle):
+    # RMS deviation from the rest value while the key is idle.
+    if not idle:
+        return float("nan")
+    return math.sqrt(sum((values[i] - rest) ** 2 for i in idle) / len(idle))
+
+
+def crossings(values, level):
+    result = []
+    for i in range(1, len(values)):
+        if (values[i - 1] > level) != (values[i] > level):
+            result.append(i)
+    return result
+
+
+def lag(raw, filtered, level):
+    # Mean delay in samples between the raw and the filtered crossing of the
+    # middle of the travel.
+    raw_x = crossings(raw, level)
+    filtered_x = crossings(filtered, level)
+    delays = []
+    for r in raw_x:
+        later = [f - r for f in filtered_x if 0 <= f - r < 50]
+        if later:
+            delays.append(later[0])
+    if not delays:
+        return float("nan")
+    return sum(delays) / len(delays)
+
+
+def synthetic_trace(rest=3000, bottom=1000, noise=8, seed=1):
+    random.seed(seed)
+    values = []
+    for stroke in range(20):
+        values += [rest] * random.randint(20, 60)
+        # fast strokes of 4 to 15 samples down and up
+        length = random.randint(4, 15)
+        for i in range(length):
+            values.append(rest + (bottom - rest) * (i + 1) // length)
+        values += [bottom] * random.randint(2, 20)
+        for i in range(length):
+            values.append(bottom + (rest - bottom) * (i + 1) // length)
+    return [min(max(int(v + random.gauss(0, noise)), 0), 4095) for v in values]
+
+
+def load_trace(path, key_id):
+    with open(path) as f:
+        reader = csv.DictReader(f)
+        return [int(row["key{}".format(key_id)]) for row in reader]
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: python filter_benchmark.py [trace.csv [key_id] | --synthetic]")
+        exit(1)
+    if sys.argv[1] == "--synthetic":
+        raw = synthetic_trace()
+    else:
+        key_id = int(sys.argv[2]) if len(sys.argv) > 2 else 0
+        raw = load_trace(sys.argv[1], key_id)
+
+    rest = max(set(raw), key=raw.count)
+    span = max(abs(max(raw) - rest), abs(min(raw) - rest), 1)
+    level = rest + (min(raw) - rest if min(raw) < rest else max(raw) - rest) / 2
+    idle = idle_indices(raw, rest, span)
+    print("{} samples, rest {}, span {}".format(len(raw), rest, span))
+    print("{:>12} {:>12} {:>12}".format("filter", "noise(LSB)", "lag(sample)"))
+
+    for alpha, beta in GAINS:
+        f = AlphaBetaFilter()
+        out = [f.update(v, alpha, beta) for v in raw]
+        name = "raw" if alpha == 0 else "ab {}/{}".format(alpha, beta)
+        print("{:>12} {:>12.2f} {:>12.2f}".format(
+            name, rest_noise(out, rest, idle), lag(raw, out, level)))
+
+    # Moving averages for comparison
+    for n in (2, 4, 8):
+        out = moving_average(raw, n)
+        print("{:>12} {:>12.2f} {:>12.2f}".format(
+            "ma {}".format(n), rest_noise(out, rest, idle), lag(raw, out, level)))
+
+
+if __name__ == "__main__":
+    main()
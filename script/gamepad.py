@@ -0,0 +1,83 @@
+import serial
+import struct
+import sys
+from ember_serial import *
+
+# open serial port
+device_name = 'COM3'
+ser = serial.Serial(device_name, timeout=1)
+
+GAMEPAD_ADDRESS = 0x1B00
+GAMEPAD_AXIS_SIZE = 16
+GAMEPAD_AXES = 6
+GAMEPAD_VALUES_ADDRESS = 0x2200
+AXIS_NAMES = ["x", "y", "z", "rx", "ry", "rz"]
+CURVE_KNOTS = 9
+
+if len(sys.argv) == 1:
+    print("Usage: python gamepad.py show")
+    print("       python gamepad.py set axis positive_key [negative_key]")
+    print("       python gamepad.py clear axis")
+    print("       python gamepad.py deadzone axis inner outer")
+    print("       python gamepad.py curve axis linear|exponent [invert]")
+    print("       python gamepad.py monitor")
+    print("  axis: " + "|".join(AXIS_NAMES))
+    print("  deadzone: fraction of the travel (0.0-1.0)")
+    print("  exponent: output = travel ^ exponent (e.g. 2.0 for fine control near rest)")
+    exit(1)
+
+result = False
+if sys.argv[1] == "show":
+    data = ember_read(ser, GAMEPAD_ADDRESS, GAMEPAD_AXIS_SIZE * GAMEPAD_AXES)
+    if data is None:
+        print("Failed to read gamepad axes")
+        exit(1)
+    for axis in range(GAMEPAD_AXES):
+        config = bytes(data[axis * GAMEPAD_AXIS_SIZE:(axis + 1) * GAMEPAD_AXIS_SIZE])
+        positive_key, negative_key, inner, outer = config[0:4]
+        curve = list(config[4:4 + CURVE_KNOTS])
+        flags = config[13]
+        if positive_key == 0 and negative_key == 0:
+            print("{:2s}: unused".format(AXIS_NAMES[axis]))
+            continue
+        keys = "+key {}".format(positive_key - 1) if positive_key else ""
+        if negative_key:
+            keys += " -key {}".format(negative_key - 1)
+        print("{:2s}: {:16s} deadzone {:.2f}/{:.2f} curve {}{}".format(
+            AXIS_NAMES[axis], keys.strip(), inner / 256, outer / 256, curve,
+            " invert" if flags & 1 else ""))
+    ser.close()
+    exit(0)
+elif sys.argv[1] == "monitor":
+    try:
+        while True:
+            data = ember_read(ser, GAMEPAD_VALUES_ADDRESS, 2 * GAMEPAD_AXES)
+            if data is None:
+                continue
+            values = struct.unpack("<6h", bytes(data))
+            print(" ".join("{}={:6d}".format(n, v) for n, v in zip(AXIS_NAMES, values)), end="\r")
+    except KeyboardInterrupt:
+        print()
+    ser.close()
+    exit(0)
+
+axis = AXIS_NAMES.index(sys.argv[2])
+address = GAMEPAD_ADDRESS + axis * GAMEPAD_AXIS_SIZE
+if sys.argv[1] == "set":
+    positive_key = int(sys.argv[3]) + 1
+    negative_key = int(sys.argv[4]) + 1 if len(sys.argv) > 4 else 0
+    result = ember_write(ser, address, [positive_key, negative_key])
+elif sys.argv[1] == "clear":
+    result = ember_write(ser, address, [0, 0])
+elif sys.argv[1] == "deadzone":
+    inner = min(255, round(float(sys.argv[3]) * 256))
+    outer = min(255, round(float(sys.argv[4]) * 256))
+    result = ember_write(ser, address + 2, [inner, outer])
+elif sys.argv[1] == "curve":
+    exponent = 1.0 if sys.argv[3] == "linear" else float(sys.argv[3])
+    curve = [round((i / (CURVE_KNOTS - 1)) ** exponent * 255) for i in range(CURVE_KNOTS)]
+    flags = 1 if "invert" in sys.argv[4:] else 0
+    result = ember_write(ser, address + 4, curve + [flags])
+
+print("Success" if result else "Failure")
+ser.close()
@@ -0,0 +1,114 @@
+import hid
+import struct
+import sys
+import time
+from telemetry_codec import TelemetryDecoder
+
+# Stream travel frames from the telemetry HID interface (no serial port needed)
+# "raw" streams the raw ADC values of every scan instead (delta encoded)
+VENDOR_ID = 0xCAFE
+TELEMETRY_USAGE_PAGE = 0xFF00
+TELEMETRY_INTERFACE = 4
+FRAME_SIZE = 64
+TRAVEL_FRAME = 0x01
+
+
+def open_telemetry():
+    for info in hid.enumerate(VENDOR_ID):
+        if info['usage_page'] == TELEMETRY_USAGE_PAGE or info['interface_number'] == TELEMETRY_INTERFACE:
+            device = hid.device()
+            device.open_path(info['path'])
+            return device
+    return None
+
+
+def parse_frame(data):
+    frame_type, key_count, _, scan, timestamp_us, pressed = struct.unpack_from('<BBHIII', data, 0)
+    if frame_type != TRAVEL_FRAME:
+        return None
+    travel = list(data[16:16 + key_count])
+    return scan, timestamp_us, pressed, travel
+
+
+if len(sys.argv) > 3:
+    print("Usage: python hid_telemetry.py [interval_ms=1|raw] [key_id]")
+    exit(1)
+
+raw = len(sys.argv) >= 2 and sys.argv[1] == 'raw'
+interval = int(sys.argv[1]) if len(sys.argv) >= 2 and not raw else 1
+key_id = int(sys.argv[2]) if len(sys.argv) >= 3 else None
+
+device = open_telemetry()
+if device is None:
+    print("Telemetry interface not found")
+    exit(1)
+
+
+def stream_raw():
+    decoder = TelemetryDecoder()
+    frames = 0
+    samples = 0
+    last_print = time.time()
+    while True:
+        data = device.read(FRAME_SIZE, 1000)
+        if not data:
+            continue
+        decoded = decoder.decode(data)
+        if not decoded:
+            continue
+        frames += 1
+        samples += len(decoded)
+        now = time.time()
+        if now - last_print >= 0.5:
+            scan, known, values = decoded[-1]
+            rate = "{:7.1f} frames/s, {:7.1f} scans/s".format(frames / (now - last_print), samples / (now - last_print))
+            if known != 0xFFFFFFFF:
+                print(rate + ", waiting for keyframes")
+            elif key_id is None:
+                print(rate + ", raw " + " ".join(str(v) for v in values[:8]) + " ...")
+            else:
+                print(rate + ", key {} raw {}".format(key_id, values[key_id]))
+            frames = 0
+            samples = 0
+            last_print = now
+
+
+if raw:
+    # Report ID 0, start raw
+    device.write([0x00, 0x02] + [0x00] * (FRAME_SIZE - 1))
+else:
+    # Report ID 0, start, interval
+    device.write([0x00, 0x01, interval] + [0x00] * (FRAME_SIZE - 2))
+frames = 0
+lost_scans = 0
+last_scan = None
+last_print = time.time()
+try:
+    if raw:
+        stream_raw()
+    while True:
+        data = device.read(FRAME_SIZE, 1000)
+        if not data:
+            continue
+        frame = parse_frame(bytes(data))
+        if frame is None:
+            continue
+        scan, timestamp_us, pressed, travel = frame
+        if last_scan is not None:
+            lost_scans += (scan - last_scan - 1) & 0xFFFFFFFF
+        last_scan = scan
+        frames += 1
+        now = time.time()
+        if now - last_print >= 0.5:
+            rate = frames / (now - last_print)
+            if key_id is None:
+                print("{:7.1f} frames/s, scans not streamed {}, pressed {:08X}".format(rate, lost_scans, pressed))
+            else:
+                print("{:7.1f} frames/s, key {} travel {:.1f}mm".format(rate, key_id, travel[key_id] / 10))
+            frames = 0
+            last_print = now
+except KeyboardInterrupt:
+    pass
+finally:
+    device.write([0x00, 0x00] + [0x00] * (FRAME_SIZE - 1))
+    device.close()
@@ -13,15 +13,17 @@ key_type = 0x00
 actuation_point = 0x03
 rappid_trigger_up_sensivity = 0x02
 rappid_trigger_down_sensivity = 0x02
+release_point = 0x02
 
 config = bytes([key_code, key_type, actuation_point,
-                rappid_trigger_up_sensivity, rappid_trigger_down_sensivity])
-result = ember_write(ser, 0x0000 + key_id * 5, config)
-if (result != 0):
+                rappid_trigger_up_sensivity, rappid_trigger_down_sensivity,
+                release_point])
+result = ember_write(ser, 0x0000 + key_id * KEY_CONFIG_SIZE, config)
+if not result:
     print("Failure")
     exit(1)
 result = ember_write(ser, 0x3000, [0x00])
-if (result != 0):
+if not result:
     print("Failure")
     exit(1)
 print("Success")
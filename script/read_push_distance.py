@@ -10,26 +10,36 @@ key_id = 0
 if len(sys.argv) > 1:
     key_id = int(sys.argv[1])
 
-key_config = ember_read(ser, 0x0000 + key_id * 5, 5)
+key_config = ember_read(ser, 0x0000 + key_id * KEY_CONFIG_SIZE, 6)
 if key_config is None:
     print("Failed to read key config")
     exit(1)
 key_code = key_config[0]
 key_type = key_config[1]
 actuation_point = key_config[2]
+release_point = key_config[5]
 
 print("Key ID  : " + str(key_id))
 print("Key Code: " + str(key_code))
 print("Key Type: " + "Threadhold" if key_type == 0 else "Rapid Trigger")
 
+print("Release : " + str(release_point / 10) + "mm")
+
 print(" " * 5 + " " * actuation_point + "\033[31m|\033[0m")
 
+# Push distance of the key every 10ms
+if not ember_subscribe(ser, 0x2000, 1, 1 << key_id, 10):
+    print("Failed to subscribe")
+    exit(1)
+
 try:
     while True:
-        data = ember_read(ser, 0x2000 + key_id, 1)
-        if data is None:
+        push = ember_read_push(ser, 1)
+        if push is None:
             continue
-        bar = "0mm |" + ("=" * data[0]) + (" " * (40 - data[0])) + "| 40mm"
+        distance = push[2][key_id][0]
+        bar = "0mm |" + ("=" * distance) + (" " * (40 - distance)) + "| 40mm"
         print("\r" + bar, end="")
 except KeyboardInterrupt:
+    ember_unsubscribe(ser, 0x2000)
     ser.close()
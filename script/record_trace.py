@@ -0,0 +1,42 @@
+import serial
+import sys
+import time
+from ember_serial import *
+
+# Record raw ADC values of all keys to a CSV file.
+# Usage: python record_trace.py trace.csv [seconds]
+
+# open serial port
+device_name = 'COM3'
+ser = serial.Serial(device_name, timeout=1)
+
+if len(sys.argv) < 2:
+    print("Usage: python record_trace.py [output.csv] [seconds=10]")
+    exit(1)
+
+duration = float(sys.argv[2]) if len(sys.argv) > 2 else 10.0
+
+# Raw ADC values of all keys every 1ms
+if not ember_subscribe(ser, 0x2100, 2, 0xFFFFFFFF, 1):
+    print("Failed to subscribe")
+    exit(1)
+
+with open(sys.argv[1], "w") as f:
+    f.write("time," + ",".join("key{}".format(i) for i in range(32)) + "\n")
+    start = time.time()
+    first_tick = None
+    count = 0
+    while time.time() - start < duration:
+        push = ember_read_push(ser, 2)
+        if push is None:
+            continue
+        _, tick, values = push
+        if first_tick is None:
+            first_tick = tick
+        f.write("{:.4f},".format((tick - first_tick) / 1000) +
+                ",".join(str(values[i][0] | values[i][1] << 8) for i in range(32)) + "\n")
+        count += 1
+    print("Recorded {} frames ({:.0f} Hz)".format(count, count / duration))
+
+ember_unsubscribe(ser, 0x2100)
+ser.close()
@@ -0,0 +1,40 @@
+import serial
+import struct
+import sys
+from ember_serial import *
+
+# open serial port
+device_name = 'COM3'
+ser = serial.Serial(device_name, timeout=1)
+
+if len(sys.argv) == 1:
+    print("Usage: python report_latency.py [option=show|clear]")
+    exit(1)
+
+if sys.argv[1] == "show":
+    data = ember_read(ser, 0x4120, 16)
+    if data is None:
+        print("Failed to read report latency")
+        exit(1)
+    samples, min_us, max_us, total_us = struct.unpack('<IIII', bytes(data))
+    if samples == 0:
+        print("No samples, press some keys first")
+    else:
+        print("Edge to report complete ({} samples)".format(samples))
+        print("  min {:6d} us".format(min_us))
+        print("  avg {:6d} us".format(total_us // samples))
+        print("  max {:6d} us".format(max_us))
+    data = ember_read(ser, 0x4130, 12)
+    if data is not None:
+        transfers, coalesced, stalls = struct.unpack('<III', bytes(data))
+        print("Transfers {}, coalesced {}, stalls {}".format(transfers, coalesced, stalls))
+    ser.close()
+    exit(0)
+
+result = False
+if sys.argv[1] == "clear":
+    # Clears the key statistics too
+    result = ember_write(ser, 0x3005, [0x00])
+
+print("Success" if result else "Failure")
+ser.close()
@@ -0,0 +1,34 @@
+import serial
+import sys
+from ember_serial import *
+
+# open serial port
+device_name = 'COM3'
+ser = serial.Serial(device_name, timeout=1)
+
+FAULTS = [(0x01, "stuck"), (0x02, "out of range"), (0x04, "noisy"), (0x08, "slew")]
+
+if len(sys.argv) == 1:
+    print("Usage: python sensor_faults.py [option=show|clear]")
+    exit(1)
+
+if sys.argv[1] == "show":
+    flags = ember_read(ser, 0x4140, 32)
+    if flags is None:
+        print("Failed to read fault flags")
+        exit(1)
+    for key_id in range(32):
+        names = [name for bit, name in FAULTS if flags[key_id] & bit]
+        if not names:
+            continue
+        state = "quarantined" if flags[key_id] & 0x80 else "recovered"
+        print("Key {:2d}: {} ({})".format(key_id, ", ".join(names), state))
+    ser.close()
+    exit(0)
+
+result = False
+if sys.argv[1] == "clear":
+    result = ember_write(ser, 0x3008, [0x00])
+
+print("Success" if result else "Failure")
+ser.close()
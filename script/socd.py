@@ -0,0 +1,48 @@
+import serial
+import struct
+import sys
+from ember_serial import *
+
+# open serial port
+device_name = 'COM3'
+ser = serial.Serial(device_name, timeout=1)
+
+SOCD_ADDRESS = 0x1900
+SOCD_GROUP_SIZE = 8
+SOCD_GROUPS = 4
+POLICIES = ["disable", "last", "first", "neutral", "deepest"]
+
+if len(sys.argv) == 1:
+    print("Usage: python socd.py show")
+    print("       python socd.py set group_id policy [key_id ...]")
+    print("  policy: " + "|".join(POLICIES))
+    exit(1)
+
+if sys.argv[1] == "show":
+    data = ember_read(ser, SOCD_ADDRESS, SOCD_GROUP_SIZE * SOCD_GROUPS)
+    if data is None:
+        print("Failed to read SOCD groups")
+        exit(1)
+    for group_id in range(SOCD_GROUPS):
+        key_mask, policy = struct.unpack_from("<IB", bytes(data), group_id * SOCD_GROUP_SIZE)
+        keys = [i for i in range(32) if key_mask & (1 << i)]
+        name = POLICIES[policy] if policy < len(POLICIES) else str(policy)
+        print("Group {}: {:8s} keys {}".format(group_id, name, keys))
+    ser.close()
+    exit(0)
+
+result = False
+if sys.argv[1] == "set":
+    group_id = int(sys.argv[2])
+    policy = POLICIES.index(sys.argv[3])
+    address = SOCD_ADDRESS + group_id * SOCD_GROUP_SIZE
+    if len(sys.argv) > 4:
+        key_mask = 0
+        for key_id in sys.argv[4:]:
+            key_mask |= 1 << int(key_id)
+        result = ember_write(ser, address, list(struct.pack("<IB", key_mask, policy)))
+    else:
+        result = ember_write(ser, address + 4, [policy])
+
+print("Success" if result else "Failure")
+ser.close()
@@ -0,0 +1,245 @@
+import struct
+import sys
+
+# Delta encoded raw ADC frames of the telemetry HID interface (TelemetryRawFrame)
+# Usage: python telemetry_codec.py trace.csv [trace.csv...]
+#   Encodes traces recorded with record_trace.py and shows the compression ratio.
+RAW_FRAME = 0x02
+FRAME_SIZE = 64
+HEADER_SIZE = 12
+RECORDS_SIZE = FRAME_SIZE - HEADER_SIZE
+KEYFRAME_INTERVAL = 32
+MAX_SCAN_GAP = 31
+HALF_MASKS = (0x0000FFFF, 0xFFFF0000)
+
+
+def _varint(value):
+    out = []
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return out
+
+
+def _zigzag(value):
+    return value << 1 if value >= 0 else (-value << 1) - 1
+
+
+def _unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+class TelemetryEncoder:
+    """Same as TelemetryEncoder of the firmware"""
+
+    def __init__(self):
+        self.previous = [0] * 32
+        self.last_scan = 0
+        self.records_since_keyframe = 0
+        self.next_half = 0
+        self.pending_keyframes = 2
+        # Sequence number of the next frame
+        self.sequence = 0
+        self._new_frame()
+
+    def _new_frame(self):
+        self.records = []
+        self.record_count = 0
+        self.scan = 0
+        self.timestamp_us = 0
+
+    def is_empty(self):
+        return self.record_count == 0
+
+    def append(self, scan, timestamp_us, values):
+        empty = self.is_empty()
+        gap = 0 if empty else (scan - self.last_scan) & 0xFFFFFFFF
+        if gap > MAX_SCAN_GAP:
+            return False
+        keyframe = self.pending_keyframes > 0 or self.records_since_keyframe >= KEYFRAME_INTERVAL
+        keyframe_mask = HALF_MASKS[self.next_half] if keyframe else 0
+
+        space = RECORDS_SIZE - len(self.records)
+        # The keyframe half first so that it is never cut short. A record that
+        # does not fit even an empty frame lists the changed keys it left out.
+        for header in (5, 9):
+            if header > space:
+                return False
+            size = header
+            encoded = {}
+            skipped = 0
+            for absolute in (True, False):
+                for i in range(32):
+                    if bool(keyframe_mask >> i & 1) != absolute:
+                        continue
+                    if not absolute and values[i] == self.previous[i]:
+                        continue
+                    if absolute:
+                        value = values[i]
+                    else:
+                        value = _zigzag(values[i] - self.previous[i])
+                    value_bytes = _varint(value)
+                    if size + len(value_bytes) > space:
+                        if not empty:
+                            return False
+                        # The next record carries the change
+                        skipped |= 1 << i
+                        continue
+                    encoded[i] = value_bytes
+                    size += len(value_bytes)
+            if not skipped:
+                break
+        keyframe_complete = keyframe and not skipped & keyframe_mask
+
+        if empty:
+            self.scan = scan
+            self.timestamp_us = timestamp_us
+        bitmap = sum(1 << i for i in encoded)
+        flags = ((0x01 | self.next_half << 1) if keyframe else 0) | gap << 2
+        if skipped:
+            flags |= 0x80
+        self.records.append(flags)
+        self.records += list(struct.pack('<I', bitmap))
+        if skipped:
+            self.records += list(struct.pack('<I', skipped))
+        for i in sorted(encoded):
+            self.records += encoded[i]
+            self.previous[i] = values[i]
+        self.record_count += 1
+        self.last_scan = scan
+
+        if keyframe_complete:
+            self.next_half ^= 1
+            self.records_since_keyframe = 0
+            if self.pending_keyframes > 0:
+                self.pending_keyframes -= 1
+        elif self.records_since_keyframe < KEYFRAME_INTERVAL:
+            self.records_since_keyframe += 1
+        return True
+
+    def finish(self):
+        frame = struct.pack('<BBBBII', RAW_FRAME, self.record_count, len(self.records),
+                            self.sequence, self.scan, self.timestamp_us)
+        self.sequence = (self.sequence + 1) & 0xFF
+        frame += bytes(self.records) + bytes(RECORDS_SIZE - len(self.records))
+        self._new_frame()
+        return frame
+
+
+class TelemetryDecoder:
+    """Same as TelemetryDecoder of the firmware"""
+
+    def __init__(self):
+        self.values = [0] * 32
+        # Keys whose value is known since the decoder started, bit i = key i
+        self.known = 0
+        # Sequence number expected next, None before the first frame
+        self.next_sequence = None
+
+    def decode(self, data):
+        """Returns [(scan, known, values)] or None if the frame is malformed"""
+        samples = self._decode(bytes(data))
+        if samples is None:
+            self.known = 0
+        return samples
+
+    def _decode(self, data):
+        if len(data) < HEADER_SIZE or data[0] != RAW_FRAME:
+            return None
+        count, length = data[1], data[2]
+        end = HEADER_SIZE + length
+        if end > len(data) or end > FRAME_SIZE:
+            return None
+        # A lost frame took deltas with it, the values are stale until keyframes
+        if self.next_sequence is not None and data[3] != self.next_sequence:
+            self.known = 0
+        self.next_sequence = (data[3] + 1) & 0xFF
+        scan = struct.unpack_from('<I', data, 4)[0]
+        pos = HEADER_SIZE
+        samples = []
+        for _ in range(count):
+            if pos + 5 > end:
+                return None
+            flags = data[pos]
+            bitmap = struct.unpack_from('<I', data, pos + 1)[0]
+            pos += 5
+            skipped = 0
+            if flags & 0x80:
+                if pos + 4 > end:
+                    return None
+                skipped = struct.unpack_from('<I', data, pos)[0]
+                pos += 4
+            keyframe_mask = HALF_MASKS[flags >> 1 & 1] if flags & 0x01 else 0
+            scan = (scan + (flags >> 2 & 0x1F)) & 0xFFFFFFFF
+            for i in range(32):
+                if not bitmap >> i & 1:
+                    continue
+                value = 0
+                shift = 0
+                while True:
+                    if pos >= end or shift > 28:
+                        return None
+                    byte = data[pos]
+                    pos += 1
+                    value |= (byte & 0x7F) << shift
+                    shift += 7
+                    if not byte & 0x80:
+                        break
+                if keyframe_mask >> i & 1:
+                    self.values[i] = value
+                    self.known |= 1 << i
+                else:
+                    self.values[i] = (self.values[i] + _unzigzag(value)) & 0xFFFF
+            # The skipped keys hold the value of an older scan
+            samples.append((scan, self.known & ~skipped, list(self.values)))
+        if pos != end:
+            return None
+        return samples
+
+
+def load_trace(path):
+    with open(path) as f:
+        f.readline()
+        return [[int(v) for v in line.strip().split(',')[1:]] for line in f if line.strip()]
+
+
+def benchmark(path):
+    trace = load_trace(path)
+    encoder = TelemetryEncoder()
+    decoder = TelemetryDecoder()
+    frames = 0
+    record_bytes = 0
+    decoded = []
+
+    def flush():
+        nonlocal frames, record_bytes
+        frame = encoder.finish()
+        frames += 1
+        record_bytes += frame[2]
+        decoded.extend(decoder.decode(frame))
+
+    # One scan per record, as if the host read a frame only when it is full
+    for scan, values in enumerate(trace):
+        if not encoder.append(scan, 0, values):
+            flush()
+            encoder.append(scan, 0, values)
+    if not encoder.is_empty():
+        flush()
+
+    # Values become exact once both keyframe halves were seen
+    exact = sum(1 for (scan, known, values) in decoded
+                if known == 0xFFFFFFFF and values == trace[scan])
+    plain = len(trace) * FRAME_SIZE
+    print("{}: {} scans, {:.1f} bytes/scan, {} frames ({:.2f} scans/frame), "
+          "ratio {:.2f}x vs 64 bytes/scan, {} scans exact".format(
+              path, len(trace), record_bytes / len(trace), frames, len(trace) / frames,
+              plain / (frames * FRAME_SIZE), exact))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print("Usage: python telemetry_codec.py [trace.csv...]")
+        exit(1)
+    for path in sys.argv[1:]:
+        benchmark(path)
@@ -0,0 +1,51 @@
+import serial
+import struct
+import sys
+from ember_serial import *
+
+# Show, save or clear the per-key usage statistics (0x6000, 0x3009).
+#
+# Usage:
+#   python usage_stats.py show
+#   python usage_stats.py save
+#   python usage_stats.py clear
+
+USAGE_STATS_ADDRESS = 0x6000
+KEY_USAGE_SIZE = 36
+USAGE_BUCKETS = 8
+READ_CHUNK = KEY_USAGE_SIZE * 6
+
+if len(sys.argv) < 2:
+    print("Usage: python usage_stats.py [show|save|clear]")
+    exit(1)
+
+# open serial port
+device_name = 'COM3'
+ser = serial.Serial(device_name, timeout=1)
+
+if sys.argv[1] == "show":
+    data = b""
+    for offset in range(0, KEY_USAGE_SIZE * 32, READ_CHUNK):
+        chunk = ember_read(ser, USAGE_STATS_ADDRESS + offset, min(READ_CHUNK, KEY_USAGE_SIZE * 32 - offset))
+        if chunk is None:
+            print("Failed to read usage statistics")
+            exit(1)
+        data += bytes(chunk)
+    print("dwell buckets: <16ms <32 <64 <128 <256 <512 <1024 >=1024ms")
+    print("depth buckets: 0.5mm each, last >=3.5mm")
+    for key_id in range(32):
+        values = struct.unpack_from("<I{}H".format(USAGE_BUCKETS * 2), data, key_id * KEY_USAGE_SIZE)
+        dwell = values[1:1 + USAGE_BUCKETS]
+        depth = values[1 + USAGE_BUCKETS:]
+        print("Key {:2d}: {:8d} dwell {} depth {}".format(key_id, values[0], list(dwell), list(depth)))
+    ser.close()
+    exit(0)
+
+result = False
+if sys.argv[1] == "save":
+    result = ember_write(ser, 0x3009, [0x01])
+elif sys.argv[1] == "clear":
+    result = ember_write(ser, 0x3009, [0x00])
+
+print("Success" if result else "Failure")
+ser.close()